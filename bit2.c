@@ -6,15 +6,24 @@
  *     Authors:    <tvales01, >
  *     Date:       <2025-09-25>
  *
- *     Implementation of a 2-D bit grid using Hanson Bit_T per column.
- *     Representation is an array-of-columns: outer UArray_T(length
- *     = width) whose elements are Bit_T vectors of length height. Bits
- *     are packed by Bit_T; API is value-based (get/put), plus row/col
- *     mapping that passes the current bit value.
+ *     Implementation of a 2-D bit grid packed into one block of 64-bit
+ *     words, row-major. Each row is padded to a whole number of words
+ *     (the word pitch, wpr), so a row scan streams through consecutive
+ *     words and a whole row is addressable as words. API is value-based
+ *     (get/put), plus row/col mapping that passes the current bit
+ *     value. The struct itself is defined in bit2_fast.h so that the
+ *     inline accessors there can reach it.
+ *
+ *     Raw PBM (P4) import: a P4 row is (width + 7) / 8 bytes with the
+ *     leftmost pixel in each byte's most significant bit. Eight bytes
+ *     are loaded as one little-endian word, which puts byte k at bits
+ *     8k..8k+7 where it belongs, and then the bits within every byte
+ *     are reversed at once with three mask-and-shift steps.
  *
  *     Dependencies:
- *       assert.h (Hanson), mem.h (NEW/FREE),
- *       uarray.h (outer array), bit.h (Bit_T).
+ *       assert.h (Hanson), mem.h (NEW/CALLOC/FREE),
+ *       bit2_fast.h (representation), sys/mman.h, fcntl.h,
+ *       sys/stat.h and unistd.h (Bit2_from_p4).
  *
  *     Indices and order:
  *       i = column, j = row.
@@ -22,33 +31,40 @@
  *
  *     Representation invariant:
  *       width >= 0; height >= 0.
- *       UArray_size(outer_bits) == sizeof(Bit_T).
- *       For each column i: Bit_length(inner) == height.
- *       Stored values are exactly {0,1}.
+ *       wpr == ceil(width / 64).
+ *       words has capacity >= height * wpr words, or is NULL when
+ *         capacity is 0; words past height * wpr are unused.
+ *       Bit (i,j) is bit i % 64 of words[j * wpr + i / 64].
+ *       Padding bits (i >= width in a row's last word) are 0.
  *
  *     Checked runtime errors (CREs):
- *       Bit2_new: width<0 || height<0.
+ *       Bit2_new / Bit2_reshape: width<0 || height<0.
  *       Bit2_get/put: NULL handle, OOB indices; put: bit ∉ {0,1}.
  *       Maps: NULL handle or NULL apply.
+ *       Bit2_find_next_set: NULL handle or cursor pointer, cursor out
+ *         of range.
+ *       Bulk operations: NULL handle; dst and src of different shape.
+ *       Bit2_from_p4: file cannot be opened or mapped; not a
+ *         well-formed P4 file; width or height <= 0; file too short.
+ *       Bit2_load_p4_rows: NULL handle or rows.
  *       Bit2_free: NULL pointer or *ptr==NULL.
  *
  **************************************************************/
 
+#define _POSIX_C_SOURCE 200809L
+
 #include "bit2.h"
-#include "bit.h"
-#include "uarray.h"
+#include "bit2_fast.h"
 #include "assert.h"
 #include "mem.h"
 
+#include <fcntl.h>
+#include <limits.h>
 #include <stdlib.h>
-
-
-
-struct Bit2_T {
-        int width;
-        int height;
-        UArray_T outer_bits;
-};
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 /********** Bit2_new ********
  * Create a 2-D bit grid of size col×row with all bits initialized to 0.
@@ -61,7 +77,8 @@ struct Bit2_T {
  *      Bit2_T: newly allocated bit grid
  *
  * Effects:
- *      Allocates heap memory for the Bit2 and its columns (Bit_T per column).
+ *      Allocates the header and one zeroed block of row * ceil(col / 64)
+ *      words.
  *
  * Checked runtime errors (CRE):
  *      CRE if col < 0 or row < 0
@@ -75,33 +92,61 @@ Bit2_T Bit2_new(int col, int row)
         assert(col >= 0 && row >= 0);
         bit2->width = col;
         bit2->height = row;
-        bit2->outer_bits = UArray_new(col, sizeof(Bit_T));
+        bit2->wpr = (col + BIT2_WORD_BITS - 1) / BIT2_WORD_BITS;
+        bit2->words = NULL;
+        bit2->capacity = (long)row * bit2->wpr;
 
-        for (int i = 0; i < col; i++)
-        {
-                Bit_T inner_bits = Bit_new(row);
-
-                Bit_T *innerp = UArray_at(bit2->outer_bits, i);
-                *innerp = inner_bits;
+        /* Hanson CALLOC rejects zero-byte requests */
+        if (bit2->capacity > 0) {
+                bit2->words = CALLOC(bit2->capacity, sizeof(*bit2->words));
         }
-        
+
         return bit2;
 }
 
-/********** Bit2_width ********
+/********** Bit2_reshape ********
+ * Give an existing grid new dimensions, with all bits 0.
  *
- * Returns the width of the bit2 array
- * 
  * Parameters:
- *      Bit2_T bit2: the bit2 array to check
+ *      Bit2_T bit2: non-NULL grid
+ *      int col:     new width, >= 0
+ *      int row:     new height, >= 0
  *
- * Return:
- *      the width of the given bit2 arary
+ * Effects:
+ *      Keeps the word block if it holds row * ceil(col / 64) words,
+ *      otherwise replaces it with a larger one; either way clears the
+ *      words in use. The block never shrinks, so reshaping a grid to
+ *      a sequence of images allocates only when an image is the
+ *      largest so far.
  *
- * Notes:
- *      CRE if bit2 is null
- * 
+ * CRE
+ *      CRE if bit2 == NULL, col < 0 or row < 0
+ *      May CRE on allocation failure
  ************************/
+void Bit2_reshape(Bit2_T bit2, int col, int row)
+{
+        assert(bit2 != NULL);
+        assert(col >= 0 && row >= 0);
+
+        int wpr = (col + BIT2_WORD_BITS - 1) / BIT2_WORD_BITS;
+        long nwords = (long)row * wpr;
+
+        if (nwords > bit2->capacity) {
+                if (bit2->words != NULL) {
+                        FREE(bit2->words);
+                }
+                bit2->words = CALLOC(nwords, sizeof(*bit2->words));
+                bit2->capacity = nwords;
+        }
+        else if (nwords > 0) {
+                memset(bit2->words, 0, nwords * sizeof(*bit2->words));
+        }
+
+        bit2->width = col;
+        bit2->height = row;
+        bit2->wpr = wpr;
+}
+
 /********** Bit2_width / Bit2_height ********
  * Return the grid dimensions.
  *
@@ -120,42 +165,12 @@ int Bit2_width(Bit2_T bit2)
         return bit2->width;
 }
 
-/********** Bit2_height ********
- *
- * Returns the height of the bit2 array
- * 
- * Parameters:
- *      Bit2_T bit2: the bit2 array to check
- *
- * Return:
- *      the height of the given bit2 arary
- *
- * Notes:
- *      CRE if bit2 is null
- * 
- ************************/
 int Bit2_height(Bit2_T bit2)
 {
         assert(bit2 != NULL);
         return bit2->height;
 }
 
-/********** Bit2_get ********
- *
- * Returns the bit value at the given index
- * 
- * Parameters:
- *      Bit2_T bit2: the bit2 array to check
- *      int col:     the column to check
- *      int row:     the row to check
- * 
- * Return:
- *      the bit value at the index
- *
- * Notes:
- *      CRE if bit2 is null or if index is out of bounds
- * 
- ************************/
 /********** Bit2_get ********
  * Read the bit at (col,row).
  *
@@ -177,33 +192,9 @@ int Bit2_get(Bit2_T bit2, int col, int row)
         assert(col >= 0 && col < bit2->width);
         assert(row >= 0 && row < bit2->height);
 
-        Bit_T *innerp = UArray_at(bit2->outer_bits, col);
-        Bit_T inner = *innerp;
-        assert(sizeof(inner) == UArray_size(bit2->outer_bits));
-
-        return Bit_get(inner, row);
+        return Bit2_get_fast(bit2, col, row);
 }
 
-/********** Bit2_put ********
- *
- * Put the given bit at the given index
- * 
- * Parameters:
- *      Bit2_T bit2: the bit2 array to check
- *      int col:     the column to put
- *      int row:     the row to put
- *      int bit:     the bit value to put (0 or 1)
- *
- * Return:
- *      the original bit value
- *
- * Notes:
- *      CRE if bit2 is null or if index is out of bounds or given bit value is
- *      not 0 or 1
- * 
- *      this function modifies the given bit2 array 
- * 
- ************************/
 /********** Bit2_put ********
  * Write the bit at (col,row), returning the previous value.
  *
@@ -228,33 +219,10 @@ int Bit2_put(Bit2_T bit2, int col, int row, int bit)
         assert(row >= 0 && row < bit2->height);
         assert(bit == 0 || bit == 1);
 
-        Bit_T *innerp = UArray_at(bit2->outer_bits, col);
-        Bit_T inner = *innerp;
-        assert(sizeof(inner) == UArray_size(bit2->outer_bits));
-
-        int prev = Bit_get(inner, row);
-
-        Bit_put(inner, row, bit);
-        return prev;
+        return Bit2_put_fast(bit2, col, row, bit);
 }
 
-/********** Bit2_map_col_major ********
- *
- * Calls apply on every element in the 2d array going column by column
- *
- * Parameters:
- *      Bit2_T bit2:  the bit2 array to traverse
- *      void apply(): the function to be called on each element
- *      void *cl:     the closure variable
- *
- * Returns: 
- *      none
- * 
- * Notes:
- *      CRE if bit2 is null
- *
- ************************/
- /********** Bit2_map_row_major ********
+/********** Bit2_map_row_major ********
  * Visit every element in row-major order and call apply for each.
  *
  * Parameters:
@@ -278,15 +246,16 @@ void Bit2_map_row_major(Bit2_T bit2,
                                   void *cl)
 {
         assert(bit2 != NULL);
-        UArray_T outer_bits = bit2->outer_bits;
+        assert(apply);
 
         for (int row = 0; row < bit2->height; row++) {
+                const uint64_t *words = bit2->words + (long)row * bit2->wpr;
+
                 for (int col = 0; col < bit2->width; col++) {
-                        Bit_T *innerp = UArray_at(outer_bits, col);
-                        Bit_T inner = *innerp;
-                        assert(sizeof(inner) == UArray_size(outer_bits));
+                        uint64_t word = words[col / BIT2_WORD_BITS];
+                        int bit = (word >> (col % BIT2_WORD_BITS)) & 1;
 
-                        apply(col, row, bit2, Bit_get(inner, row), cl);
+                        apply(col, row, bit2, bit, cl);
                 }
         }
 }
@@ -300,68 +269,433 @@ void Bit2_map_col_major(Bit2_T bit2,
                                   void *cl)
 {
         assert(bit2 != NULL);
-        UArray_T outer_bits = bit2->outer_bits;
+        assert(apply);
 
         for (int col = 0; col < bit2->width; col++) {
-                Bit_T *innerp = UArray_at(outer_bits, col);
-                Bit_T inner = *innerp;
-                assert(sizeof(inner) == UArray_size(outer_bits));
+                const uint64_t *word = bit2->words + col / BIT2_WORD_BITS;
+                int shift = col % BIT2_WORD_BITS;
 
-                for (int row = 0; row < bit2->height; row++) {
-                        apply(col, row, bit2, Bit_get(inner, row), cl);
+                for (int row = 0; row < bit2->height;
+                     row++, word += bit2->wpr) {
+                        apply(col, row, bit2, (*word >> shift) & 1, cl);
                 }
         }
 
 }
 
-/********** Bit2_map_row_major ********
- *
- * Calls apply on every element in the 2d array going row by row
+/********** Bit2_map_set_bits ********
+ * Call apply for every bit that is 1, in row-major order.
  *
  * Parameters:
- *      Bit2_T bit2:  the bit2 array to traverse
- *      void apply(): the function to be called on each element
- *      void *cl:     the closure variable
+ *      Bit2_T bit2: grid
+ *      void apply(int col, int row, Bit2_T b, int value, void *cl):
+ *                   same callback as the maps; value is always 1
+ *      void *cl:    closure pointer passed to each call
+ *
+ * Returns:
+ *      None
+ *
+ * Effects:
+ *      Skips zero words outright and finds each set bit in a word with
+ *      count-trailing-zeros, so the cost is one step per word plus one
+ *      per set bit rather than one callback per cell.
  *
- * Returns: 
- *      none
- * 
  * Notes:
- *      CRE if bit2 is null
+ *      Each word is read once, before its bits are visited: apply may
+ *      clear or set bits, but changes to the word being visited (or
+ *      earlier ones) do not change which of its bits are reported.
  *
+ * CRE
+ *      CRE if bit2 == NULL or apply == NULL
  ************************/
-void Bit2_map_row_major(Bit2_T bit2,
+void Bit2_map_set_bits(Bit2_T bit2,
                                   void apply(int col, int row, Bit2_T bit2,
                                              int bit, void *cl),
                                   void *cl)
 {
         assert(bit2 != NULL);
-        UArray_T outer_bits = bit2->outer_bits;
+        assert(apply);
 
         for (int row = 0; row < bit2->height; row++) {
-                for (int col = 0; col < bit2->width; col++) {
-                        Bit_T *innerp = UArray_at(outer_bits, col);
-                        Bit_T inner = *innerp;
-                        assert(sizeof(inner) == UArray_size(outer_bits));
+                const uint64_t *words = bit2->words + (long)row * bit2->wpr;
+
+                for (int w = 0; w < bit2->wpr; w++) {
+                        uint64_t word = words[w];
 
-                        apply(col, row, bit2, Bit_get(inner, row), cl);
+                        while (word != 0) {
+                                int bit = __builtin_ctzll(word);
+                                word &= word - 1;       /* drop lowest 1 */
+                                apply(w * BIT2_WORD_BITS + bit, row, bit2, 1,
+                                      cl);
+                        }
                 }
         }
 }
 
-/********** Bit2_free ********
+/********** Bit2_find_next_set ********
+ * Advance a row-major cursor to the next bit that is 1.
+ *
+ * Parameters:
+ *      Bit2_T bit2: non-NULL grid
+ *      int *col:    in: column to start at (0 <= *col <= width; width
+ *                   means "start of the next row"); out: column found
+ *      int *row:    in: row to start at (0 <= *row <= height);
+ *                   out: row found
+ *
+ * Returns:
+ *      1 if a set bit was found at or after (*col,*row) in row-major
+ *      order, and stores its position in *col, *row; 0 if there is
+ *      none, leaving *col and *row unchanged.
+ *
+ * Notes:
+ *      Typical loop:
+ *          int col = 0, row = 0;
+ *          while (Bit2_find_next_set(b, &col, &row)) { ...; col++; }
+ *
+ * CRE
+ *      CRE if bit2, col or row is NULL, or the cursor is out of range
+ ************************/
+int Bit2_find_next_set(Bit2_T bit2, int *col, int *row)
+{
+        assert(bit2 != NULL && col != NULL && row != NULL);
+        assert(*col >= 0 && *col <= bit2->width);
+        assert(*row >= 0 && *row <= bit2->height);
+
+        int r = *row;
+        int w = *col / BIT2_WORD_BITS;
+        /* bits of the first word before the cursor are masked off */
+        uint64_t skip = *col % BIT2_WORD_BITS;
+
+        for (; r < bit2->height; r++, w = 0, skip = 0) {
+                const uint64_t *words = bit2->words + (long)r * bit2->wpr;
+
+                for (; w < bit2->wpr; w++, skip = 0) {
+                        uint64_t word = words[w] & (~(uint64_t)0 << skip);
+
+                        if (word != 0) {
+                                *col = w * BIT2_WORD_BITS
+                                     + __builtin_ctzll(word);
+                                *row = r;
+                                return 1;
+                        }
+                }
+        }
+        return 0;
+}
+
+/********** Bulk operations ********
+ * Grids of the same shape have the same word layout, so each operation
+ * is one pass over height * wpr words. The loops have no dependences
+ * between words, so the compiler can vectorize them.
+ ************************/
+
+/********** same_shape (static helper) ********
+ * Assert that dst and src are non-NULL and have the same dimensions;
+ * return the number of words each holds.
+ ************************/
+static long same_shape(Bit2_T dst, Bit2_T src)
+{
+        assert(dst != NULL && src != NULL);
+        assert(dst->width == src->width && dst->height == src->height);
+        (void)src;
+
+        return dst->words == NULL ? 0 : (long)dst->height * dst->wpr;
+}
+
+/********** Bit2_and / Bit2_or / Bit2_xor / Bit2_andnot ********
+ * Combine src into dst bit by bit:
+ *      and:    dst = dst & src
+ *      or:     dst = dst | src
+ *      xor:    dst = dst ^ src
+ *      andnot: dst = dst & ~src   (clear every bit that is set in src)
+ *
+ * Parameters:
+ *      Bit2_T dst: grid updated in place
+ *      Bit2_T src: grid of the same width and height (may be dst)
+ *
+ * Returns:
+ *      None
+ *
+ * CRE
+ *      CRE if dst or src is NULL or their dimensions differ
+ ************************/
+void Bit2_and(Bit2_T dst, Bit2_T src)
+{
+        long n = same_shape(dst, src);
+        uint64_t *d = dst->words;
+        const uint64_t *s = src->words;
+
+        for (long k = 0; k < n; k++) {
+                d[k] &= s[k];
+        }
+}
+
+void Bit2_or(Bit2_T dst, Bit2_T src)
+{
+        long n = same_shape(dst, src);
+        uint64_t *d = dst->words;
+        const uint64_t *s = src->words;
+
+        for (long k = 0; k < n; k++) {
+                d[k] |= s[k];
+        }
+}
+
+void Bit2_xor(Bit2_T dst, Bit2_T src)
+{
+        long n = same_shape(dst, src);
+        uint64_t *d = dst->words;
+        const uint64_t *s = src->words;
+
+        for (long k = 0; k < n; k++) {
+                d[k] ^= s[k];
+        }
+}
+
+void Bit2_andnot(Bit2_T dst, Bit2_T src)
+{
+        long n = same_shape(dst, src);
+        uint64_t *d = dst->words;
+        const uint64_t *s = src->words;
+
+        for (long k = 0; k < n; k++) {
+                d[k] &= ~s[k];
+        }
+}
+
+/********** Bit2_not ********
+ * Invert every bit of the grid in place.
  *
- * Free all the memory associated with the bit2 array
+ * Parameters:
+ *      Bit2_T bit2: non-NULL grid
+ *
+ * Effects:
+ *      Flips whole words, then clears the padding bits of each row's
+ *      last word so the representation invariant holds.
+ *
+ * CRE
+ *      CRE if bit2 == NULL
+ ************************/
+void Bit2_not(Bit2_T bit2)
+{
+        long n = same_shape(bit2, bit2);
+        uint64_t *w = bit2->words;
+
+        for (long k = 0; k < n; k++) {
+                w[k] = ~w[k];
+        }
+
+        int tail = bit2->width % BIT2_WORD_BITS;
+        if (n > 0 && tail != 0) {
+                uint64_t keep = ((uint64_t)1 << tail) - 1;
+
+                for (int row = 0; row < bit2->height; row++) {
+                        w[(long)row * bit2->wpr + bit2->wpr - 1] &= keep;
+                }
+        }
+}
+
+/********** Bit2_count ********
+ * Return the number of bits that are 1.
  *
  * Parameters:
- *      Bit2_T bit2:  the bit2 array to free
+ *      Bit2_T bit2: non-NULL grid
+ *
+ * CRE
+ *      CRE if bit2 == NULL
+ ************************/
+long Bit2_count(Bit2_T bit2)
+{
+        long n = same_shape(bit2, bit2);
+        const uint64_t *w = bit2->words;
+        long count = 0;
+
+        for (long k = 0; k < n; k++) {
+                count += __builtin_popcountll(w[k]);
+        }
+        return count;
+}
+
+/********** reverse_bytes (static helper) ********
+ * Reverse the order of the 8 bits inside each byte of word.
+ ************************/
+static inline uint64_t reverse_bytes(uint64_t word)
+{
+        word = ((word >> 1) & 0x5555555555555555ULL)
+             | ((word & 0x5555555555555555ULL) << 1);
+        word = ((word >> 2) & 0x3333333333333333ULL)
+             | ((word & 0x3333333333333333ULL) << 2);
+        word = ((word >> 4) & 0x0F0F0F0F0F0F0F0FULL)
+             | ((word & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        return word;
+}
+
+/********** load_le (static helper) ********
+ * Return n (1..8) bytes as a little-endian word; missing bytes are 0.
+ ************************/
+static inline uint64_t load_le(const unsigned char *bytes, int n)
+{
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if (n == 8) {
+                uint64_t word;
+                memcpy(&word, bytes, sizeof(word));
+                return word;
+        }
+#endif
+        uint64_t word = 0;
+        for (int b = 0; b < n; b++) {
+                word |= (uint64_t)bytes[b] << (8 * b);
+        }
+        return word;
+}
+
+/********** Bit2_load_p4_rows ********
+ * Overwrite every bit from raw PBM (P4) pixel data.
+ *
+ * Parameters:
+ *      Bit2_T bit2:                grid to fill (its width and height
+ *                                  are the image's)
+ *      const unsigned char *rows:  height rows of (width + 7) / 8
+ *                                  bytes each, MSB = leftmost pixel,
+ *                                  1 = black
+ *
+ * Effects:
+ *      Converts a word (64 pixels) at a time; bits past width in a
+ *      row's last byte are dropped so padding stays 0. A grid of width
+ *      or height 0 is left as it is and rows is not read.
+ *
+ * CRE
+ *      CRE if bit2 == NULL or rows == NULL
+ ************************/
+void Bit2_load_p4_rows(Bit2_T bit2, const unsigned char *rows)
+{
+        assert(bit2 != NULL && rows != NULL);
+
+        /* A zero-width grid has no words, not even a last one to mask */
+        if (bit2->wpr == 0) {
+                return;
+        }
+
+        long row_bytes = (bit2->width + 7L) / 8;
+        uint64_t tail = bit2->width % BIT2_WORD_BITS == 0
+                      ? ~(uint64_t)0
+                      : ((uint64_t)1 << (bit2->width % BIT2_WORD_BITS)) - 1;
+
+        for (int row = 0; row < bit2->height; row++) {
+                const unsigned char *src = rows + row * row_bytes;
+                uint64_t *dst = bit2->words + (long)row * bit2->wpr;
+
+                for (int k = 0; k < bit2->wpr; k++) {
+                        long left = row_bytes - 8L * k;
+                        int n = left < 8 ? (int)left : 8;
+
+                        dst[k] = reverse_bytes(load_le(src + 8L * k, n));
+                }
+                dst[bit2->wpr - 1] &= tail;
+        }
+}
+
+/********** is_space (static helper) ********
+ * Return whether c is netpbm whitespace (space, \t \n \v \f \r).
+ ************************/
+static inline int is_space(unsigned char c)
+{
+        return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+/********** p4_number (static helper) ********
+ * Parse a header number at bytes[*pos], skipping whitespace and #
+ * comments before it. Returns -1 if there is none or it is too large.
+ ************************/
+static long p4_number(const unsigned char *bytes, long length, long *pos)
+{
+        long i = *pos;
+
+        while (i < length) {
+                if (bytes[i] == '#') {
+                        while (i < length && bytes[i] != '\n') {
+                                i++;
+                        }
+                }
+                else if (is_space(bytes[i])) {
+                        i++;
+                }
+                else {
+                        break;
+                }
+        }
+
+        long n = -1;
+        while (i < length && bytes[i] >= '0' && bytes[i] <= '9') {
+                n = (n < 0 ? 0 : n) * 10 + (bytes[i++] - '0');
+                if (n > INT_MAX) {
+                        return -1;
+                }
+        }
+
+        *pos = i;
+        return n;
+}
+
+/********** Bit2_from_p4 ********
+ * Load a raw PBM (P4) file into a new grid.
+ *
+ * Parameters:
+ *      const char *path: P4 file
+ *
+ * Returns:
+ *      Bit2_T: new grid, 1 = black; the caller frees it
+ *
+ * Effects:
+ *      Maps the file read-only, parses the header, and imports the
+ *      pixel rows with Bit2_load_p4_rows straight from the mapping;
+ *      the file is unmapped and closed before returning.
  *
- * Returns: none
- * 
  * Notes:
- *      CRE if bit2 or *bit2 is null
+ *      A P4 row is padded to 8 bits and a Bit2 row to 64, with the
+ *      opposite bit order, so the mapping cannot serve as the grid's
+ *      storage; the import is one pass over the payload.
  *
+ * CRE
+ *      CRE if path cannot be opened or mapped, the header is not a P4
+ *      header with width and height > 0, or the file is too short
  ************************/
+Bit2_T Bit2_from_p4(const char *path)
+{
+        assert(path != NULL);
+
+        int fd = open(path, O_RDONLY);
+        assert(fd >= 0);
+
+        struct stat st;
+        int rc = fstat(fd, &st);
+        assert(rc == 0 && st.st_size > 2);
+        (void)rc;
+        long length = st.st_size;
+        const unsigned char *bytes = mmap(NULL, length, PROT_READ,
+                                          MAP_PRIVATE, fd, 0);
+        assert(bytes != MAP_FAILED);
+
+        assert(bytes[0] == 'P' && bytes[1] == '4');
+        long pos = 2;
+        long width = p4_number(bytes, length, &pos);
+        long height = p4_number(bytes, length, &pos);
+        assert(width > 0 && height > 0);
+
+        /* exactly one whitespace byte ends the header */
+        assert(pos < length && is_space(bytes[pos]));
+        pos++;
+        assert((length - pos) / height >= (width + 7) / 8);
+
+        Bit2_T bit2 = Bit2_new((int)width, (int)height);
+        Bit2_load_p4_rows(bit2, bytes + pos);
+
+        munmap((void *)bytes, length);
+        close(fd);
+
+        return bit2;
+}
+
 /********** Bit2_free ********
  * Dispose of a Bit2 grid and set *bit2 to NULL.
  *
@@ -372,7 +706,7 @@ void Bit2_map_row_major(Bit2_T bit2,
  *      None
  *
  * Effects:
- *      Frees all columns and the outer structure; sets *bit2 = NULL.
+ *      Frees the word block and the header; sets *bit2 = NULL.
  *
  * CRE
  *      CRE if bit2 == NULL or *bit2 == NULL
@@ -380,10 +714,8 @@ void Bit2_map_row_major(Bit2_T bit2,
 void Bit2_free(Bit2_T *bit2) {
         assert(bit2 != NULL && *bit2 != NULL);
 
-        for (int col = 0; col < (*bit2)->width; col++) {
-                Bit_T *innerp = UArray_at((*bit2)->outer_bits, col);
-                Bit_free(innerp);
+        if ((*bit2)->words != NULL) {
+                FREE((*bit2)->words);
         }
-        UArray_free(&(*bit2)->outer_bits);
         FREE(*bit2);
 }
\ No newline at end of file
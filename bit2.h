@@ -17,6 +17,20 @@
  *
  *     Notes:
  *       get returns 0 or 1; put sets 0/1 and returns previous value.
+ *       Bits are packed row-major into 64-bit words, so row-major
+ *       traversal is the fast order.
+ *       Whole-grid operations (and/or/xor/andnot) update dst in place
+ *       from a src of the same shape, 64 bits at a time; Bit2_not
+ *       inverts a grid in place and Bit2_count counts its 1 bits, also
+ *       a word at a time.
+ *       Bit2_map_set_bits / Bit2_find_next_set visit only bits that
+ *       are 1, in row-major order, skipping all-zero words.
+ *       Bit2_reshape reuses a grid for new dimensions, keeping its
+ *       storage when it is large enough, so one grid can serve a
+ *       stream of images.
+ *       Bit2_from_p4 loads a raw PBM (P4) file through mmap;
+ *       Bit2_load_p4_rows imports P4 pixel rows already in memory.
+ *       Both convert 64 pixels per step, never one pixel at a time.
  *       Function contracts are documented in bit2.c.
  *
  **************************************************************/
@@ -27,6 +41,7 @@
 typedef struct Bit2_T *Bit2_T;
 
 extern Bit2_T Bit2_new(int col, int row);
+extern void Bit2_reshape(Bit2_T bit2, int col, int row);
 extern void Bit2_free(Bit2_T *bit2);
 
 extern int Bit2_width (Bit2_T bit2);
@@ -45,4 +60,21 @@ extern void Bit2_map_col_major(
         void apply(int col, int row, Bit2_T bit2, int bit, void *cl),
         void *cl);
 
-#endif 
\ No newline at end of file
+extern void Bit2_map_set_bits(
+        Bit2_T bit2,
+        void apply(int col, int row, Bit2_T bit2, int bit, void *cl),
+        void *cl);
+
+extern int Bit2_find_next_set(Bit2_T bit2, int *col, int *row);
+
+extern void Bit2_and   (Bit2_T dst, Bit2_T src);
+extern void Bit2_or    (Bit2_T dst, Bit2_T src);
+extern void Bit2_xor   (Bit2_T dst, Bit2_T src);
+extern void Bit2_andnot(Bit2_T dst, Bit2_T src);
+extern void Bit2_not   (Bit2_T bit2);
+extern long Bit2_count (Bit2_T bit2);
+
+extern Bit2_T Bit2_from_p4(const char *path);
+extern void Bit2_load_p4_rows(Bit2_T bit2, const unsigned char *rows);
+
+#endif
\ No newline at end of file
@@ -0,0 +1,140 @@
+/**************************************************************
+ *
+ *                       bit2_fast.h
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    <tvales01>
+ *     Date:       <2025-09-25>
+ *
+ *     Representation of Bit2_T plus inline get/put for hot loops.
+ *     Bit2_get_fast / Bit2_put_fast behave like Bit2_get / Bit2_put
+ *     but are expanded at the call site. Bit2_row_fast exposes a row
+ *     as packed 64-bit words for code that works a word at a time, and
+ *     Bit2_set_run_fast / Bit2_clear_run_fast set or clear a run of
+ *     bits in such a row.
+ *
+ *     Layout:
+ *       Rows are stored one after another, each padded to a whole
+ *       number of 64-bit words (wpr words per row). Bit (i,j) is bit
+ *       i % 64 (counting from the least significant bit) of word
+ *       j * wpr + i / 64. Padding bits past width are always 0.
+ *
+ *     Checking:
+ *       By default the fast accessors check the same CREs as bit2.c.
+ *       When compiled with -DUNCHECKED_ACCESS (the release build in
+ *       the Makefile) the handle, bounds and bit-value checks are
+ *       compiled out; out-of-range indices are then unchecked errors.
+ *
+ *     Notes:
+ *       Only code that needs the speed should include this header;
+ *       everything else should go through bit2.h. Code that writes
+ *       whole words must keep the padding bits 0.
+ *
+ **************************************************************/
+
+#ifndef BIT2_FAST_INCLUDED
+#define BIT2_FAST_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "bit2.h"
+#include "assert.h"
+
+#ifdef UNCHECKED_ACCESS
+#define BIT2_CHECK(e) ((void)0)
+#else
+#define BIT2_CHECK(e) assert(e)
+#endif
+
+/* Bits per storage word */
+#define BIT2_WORD_BITS 64
+
+struct Bit2_T {
+        int width;
+        int height;
+        int wpr;                /* words per row */
+        uint64_t *words;        /* height rows of wpr words, or NULL */
+        long capacity;          /* words allocated (>= height * wpr) */
+};
+
+static inline int Bit2_get_fast(Bit2_T bit2, int col, int row)
+{
+        BIT2_CHECK(bit2 != NULL);
+        BIT2_CHECK(col >= 0 && col < bit2->width);
+        BIT2_CHECK(row >= 0 && row < bit2->height);
+
+        uint64_t word = bit2->words[(long)row * bit2->wpr
+                                    + col / BIT2_WORD_BITS];
+        return (int)((word >> (col % BIT2_WORD_BITS)) & 1);
+}
+
+static inline int Bit2_put_fast(Bit2_T bit2, int col, int row, int bit)
+{
+        BIT2_CHECK(bit2 != NULL);
+        BIT2_CHECK(col >= 0 && col < bit2->width);
+        BIT2_CHECK(row >= 0 && row < bit2->height);
+        BIT2_CHECK(bit == 0 || bit == 1);
+
+        uint64_t *word = &bit2->words[(long)row * bit2->wpr
+                                      + col / BIT2_WORD_BITS];
+        uint64_t mask = (uint64_t)1 << (col % BIT2_WORD_BITS);
+        int prev = (*word & mask) != 0;
+
+        *word = (*word & ~mask) | ((uint64_t)bit << (col % BIT2_WORD_BITS));
+        return prev;
+}
+
+static inline uint64_t *Bit2_row_fast(Bit2_T bit2, int row)
+{
+        BIT2_CHECK(bit2 != NULL);
+        BIT2_CHECK(row >= 0 && row < bit2->height);
+
+        return bit2->words + (long)row * bit2->wpr;
+}
+
+/* Set bits left..right (inclusive) of a packed row, a word at a time */
+static inline void Bit2_set_run_fast(uint64_t *words, int left, int right)
+{
+        BIT2_CHECK(left >= 0 && left <= right);
+
+        int first = left / BIT2_WORD_BITS;
+        int last = right / BIT2_WORD_BITS;
+        uint64_t head = ~(uint64_t)0 << (left % BIT2_WORD_BITS);
+        uint64_t tail = ~(uint64_t)0 >> (BIT2_WORD_BITS - 1
+                                         - right % BIT2_WORD_BITS);
+
+        if (first == last) {
+                words[first] |= head & tail;
+                return;
+        }
+        words[first] |= head;
+        for (int k = first + 1; k < last; k++) {
+                words[k] = ~(uint64_t)0;
+        }
+        words[last] |= tail;
+}
+
+/* Clear bits left..right (inclusive) of a packed row, a word at a time */
+static inline void Bit2_clear_run_fast(uint64_t *words, int left, int right)
+{
+        BIT2_CHECK(left >= 0 && left <= right);
+
+        int first = left / BIT2_WORD_BITS;
+        int last = right / BIT2_WORD_BITS;
+        uint64_t head = ~(uint64_t)0 << (left % BIT2_WORD_BITS);
+        uint64_t tail = ~(uint64_t)0 >> (BIT2_WORD_BITS - 1
+                                         - right % BIT2_WORD_BITS);
+
+        if (first == last) {
+                words[first] &= ~(head & tail);
+                return;
+        }
+        words[first] &= ~head;
+        for (int k = first + 1; k < last; k++) {
+                words[k] = 0;
+        }
+        words[last] &= ~tail;
+}
+
+#endif
@@ -21,6 +21,261 @@ check_and_print(int i, int j, Bit2_T a, int b, void *p1)
         printf("ar[%d,%d]\n", i, j);
 }
 
+/* Bits of the packed test grid: set where the word boundaries are */
+const int WIDE = 130;
+const int PACKED_COLS[] = { 0, 63, 64, 65, 127, 128, 129 };
+
+bool packed_bit(int i, int j)
+{
+        int n = sizeof(PACKED_COLS) / sizeof(PACKED_COLS[0]);
+
+        for (int k = 0; j == 1 && k < n; k++) {
+                if (PACKED_COLS[k] == i) {
+                        return true;
+                }
+        }
+        return false;
+}
+
+struct visit {
+        bool ok;
+        int count;
+};
+
+void check_packed(int i, int j, Bit2_T a, int b, void *p1)
+{
+        struct visit *v = p1;
+
+        (void)a;
+        v->ok &= b == packed_bit(i, j);
+        v->count++;
+}
+
+/* Patterns for the bulk operations; 70 columns leave a 6-bit tail */
+const int BULK_W = 70;
+const int BULK_H = 3;
+
+int pattern_a(int i, int j) { return (i + j) % 3 == 0; }
+int pattern_b(int i, int j) { return i % 2 == 0 || j == 2; }
+
+Bit2_T make_grid(int width, int height, int pattern(int i, int j))
+{
+        Bit2_T grid = Bit2_new(width, height);
+
+        for (int j = 0; j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                        Bit2_put(grid, i, j, pattern(i, j));
+                }
+        }
+        return grid;
+}
+
+/* Apply op to a copy of pattern a with pattern b; compare with want */
+bool check_op(void op(Bit2_T dst, Bit2_T src), int want(int a, int b))
+{
+        Bit2_T dst = make_grid(BULK_W, BULK_H, pattern_a);
+        Bit2_T src = make_grid(BULK_W, BULK_H, pattern_b);
+        bool ok = true;
+        long ones = 0;
+
+        op(dst, src);
+        for (int j = 0; j < BULK_H; j++) {
+                for (int i = 0; i < BULK_W; i++) {
+                        int bit = want(pattern_a(i, j), pattern_b(i, j));
+                        ok &= Bit2_get(dst, i, j) == bit;
+                        ok &= Bit2_get(src, i, j) == pattern_b(i, j);
+                        ones += bit;
+                }
+        }
+        ok &= Bit2_count(dst) == ones;
+
+        Bit2_free(&dst);
+        Bit2_free(&src);
+        return ok;
+}
+
+int want_and(int a, int b)    { return a & b; }
+int want_or(int a, int b)     { return a | b; }
+int want_xor(int a, int b)    { return a ^ b; }
+int want_andnot(int a, int b) { return a & !b; }
+
+/* Bit2_not must leave the padding 0, or Bit2_count would see it */
+bool check_not(int width, int height)
+{
+        Bit2_T grid = make_grid(width, height, pattern_a);
+        long ones = Bit2_count(grid);
+        bool ok = true;
+
+        Bit2_not(grid);
+        ok &= Bit2_count(grid) == (long)width * height - ones;
+        for (int j = 0; j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                        ok &= Bit2_get(grid, i, j) == !pattern_a(i, j);
+                }
+        }
+        Bit2_not(grid);
+        ok &= Bit2_count(grid) == ones;
+
+        Bit2_free(&grid);
+        return ok;
+}
+
+/* Set bits in row-major order, ending on the grid's very last bit */
+const int SPARSE_W = 130;
+const int SPARSE_H = 4;
+const int SPARSE[][2] = { { 5, 0 }, { 64, 0 }, { 0, 2 }, { 63, 2 },
+                          { 128, 2 }, { 129, 3 } };
+const int NSPARSE = 6;
+
+struct sparse {
+        bool ok;
+        int count;
+};
+
+void check_sparse(int i, int j, Bit2_T a, int b, void *p1)
+{
+        struct sparse *s = p1;
+
+        (void)a;
+        s->ok &= b == 1 && s->count < NSPARSE && SPARSE[s->count][0] == i
+                 && SPARSE[s->count][1] == j;
+        s->count++;
+}
+
+/* Both iterators report exactly the SPARSE bits, in order */
+bool check_set_bits(void)
+{
+        Bit2_T grid = Bit2_new(SPARSE_W, SPARSE_H);
+        for (int k = 0; k < NSPARSE; k++) {
+                Bit2_put(grid, SPARSE[k][0], SPARSE[k][1], 1);
+        }
+
+        struct sparse s = { true, 0 };
+        Bit2_map_set_bits(grid, check_sparse, &s);
+        bool ok = s.ok && s.count == NSPARSE;
+
+        int col = 0, row = 0, n = 0;
+        while (Bit2_find_next_set(grid, &col, &row)) {
+                ok &= n < NSPARSE && SPARSE[n][0] == col
+                      && SPARSE[n][1] == row;
+                n++;
+                col++;
+        }
+        /* the cursor stops one past the last bit, i.e. at the width */
+        ok &= n == NSPARSE && col == SPARSE_W && row == SPARSE_H - 1;
+
+        /* col == width starts at the next row */
+        col = SPARSE_W;
+        row = 0;
+        ok &= Bit2_find_next_set(grid, &col, &row) && col == 0 && row == 2;
+
+        Bit2_free(&grid);
+        return ok;
+}
+
+/* No calls and no hits on grids without set bits */
+bool check_no_bits(int width, int height)
+{
+        Bit2_T grid = Bit2_new(width, height);
+        struct sparse s = { true, 0 };
+        int col = 0, row = 0;
+
+        Bit2_map_set_bits(grid, check_sparse, &s);
+        bool ok = s.count == 0 && !Bit2_find_next_set(grid, &col, &row)
+                  && col == 0 && row == 0;
+
+        Bit2_free(&grid);
+        return ok;
+}
+
+/* P4 widths around the byte and word boundaries */
+const int P4_WIDTHS[] = { 1, 7, 8, 63, 64, 65 };
+const int NP4_WIDTHS = 6;
+const int P4_H = 3;
+const char *P4_PATH = "bit2_test.tmp";
+
+/*
+ * Pack pattern_a into P4 rows (MSB = leftmost pixel), with every
+ * padding bit in a row's last byte set so the loaders must drop it
+ */
+unsigned char *p4_rows(int width, int height)
+{
+        int row_bytes = (width + 7) / 8;
+        unsigned char *rows = calloc(row_bytes * height, 1);
+
+        for (int j = 0; j < height; j++) {
+                unsigned char *row = rows + j * row_bytes;
+
+                for (int i = 0; i < width; i++) {
+                        if (pattern_a(i, j)) {
+                                row[i / 8] |= 0x80 >> (i % 8);
+                        }
+                }
+                row[row_bytes - 1] |= 0xFF >> (width % 8 == 0 ? 8
+                                                               : width % 8);
+        }
+        return rows;
+}
+
+/* grid holds exactly pattern_a, with its padding still 0 */
+bool check_p4_grid(Bit2_T grid, int width, int height)
+{
+        long ones = 0;
+        bool ok = Bit2_width(grid) == width && Bit2_height(grid) == height;
+
+        for (int j = 0; ok && j < height; j++) {
+                for (int i = 0; i < width; i++) {
+                        ok &= Bit2_get(grid, i, j) == pattern_a(i, j);
+                        ones += pattern_a(i, j);
+                }
+        }
+        return ok && Bit2_count(grid) == ones;
+}
+
+/* Bit2_load_p4_rows and Bit2_from_p4 agree with the packed pattern */
+bool check_p4(int width, int height)
+{
+        int row_bytes = (width + 7) / 8;
+        unsigned char *rows = p4_rows(width, height);
+
+        Bit2_T grid = Bit2_new(width, height);
+        Bit2_not(grid);         /* every old bit must be overwritten */
+        Bit2_load_p4_rows(grid, rows);
+        bool ok = check_p4_grid(grid, width, height);
+        Bit2_free(&grid);
+
+        FILE *fp = fopen(P4_PATH, "wb");
+        if (fp == NULL) {
+                free(rows);
+                return false;
+        }
+        fprintf(fp, "P4\n# comment\n%d %d\n", width, height);
+        ok &= fwrite(rows, row_bytes, height, fp) == (size_t)height;
+        ok &= fclose(fp) == 0;
+
+        grid = Bit2_from_p4(P4_PATH);
+        ok &= check_p4_grid(grid, width, height);
+        Bit2_free(&grid);
+
+        remove(P4_PATH);
+        free(rows);
+        return ok;
+}
+
+/* A zero-width grid has no words for Bit2_load_p4_rows to touch */
+bool check_p4_empty(int height)
+{
+        const unsigned char guard = 0xFF;
+        Bit2_T grid = Bit2_new(0, height);
+
+        Bit2_load_p4_rows(grid, &guard);
+        bool ok = Bit2_width(grid) == 0 && Bit2_height(grid) == height
+                  && Bit2_count(grid) == 0;
+
+        Bit2_free(&grid);
+        return ok;
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -57,6 +312,43 @@ main(int argc, char *argv[])
 
         Bit2_free(&test_array);
 
+        /* neighbours across a word boundary do not disturb each other */
+        test_array = Bit2_new(WIDE, 3);
+        for (int k = 0; k < 7; k++) {
+                Bit2_put(test_array, PACKED_COLS[k], 1, 1);
+        }
+        struct visit v = { true, 0 };
+        Bit2_map_row_major(test_array, check_packed, &v);
+        OK &= v.ok && v.count == WIDE * 3;
+        v = (struct visit){ true, 0 };
+        Bit2_map_col_major(test_array, check_packed, &v);
+        OK &= v.ok && v.count == WIDE * 3;
+        OK &= Bit2_put(test_array, 64, 1, 0) == 1
+              && Bit2_get(test_array, 63, 1) == 1
+              && Bit2_get(test_array, 65, 1) == 1;
+        Bit2_free(&test_array);
+
+        /* set-bit iteration */
+        OK &= check_set_bits();
+        OK &= check_no_bits(0, 0) && check_no_bits(5, 0)
+              && check_no_bits(0, 5) && check_no_bits(SPARSE_W, SPARSE_H);
+
+        /* whole-grid operations */
+        OK &= check_op(Bit2_and, want_and);
+        OK &= check_op(Bit2_or, want_or);
+        OK &= check_op(Bit2_xor, want_xor);
+        OK &= check_op(Bit2_andnot, want_andnot);
+        OK &= check_not(BULK_W, BULK_H) && check_not(64, 2)
+              && check_not(1, 5) && check_not(0, 0);
+
+        /* P4 import */
+        for (int k = 0; k < NP4_WIDTHS; k++) {
+                OK &= check_p4(P4_WIDTHS[k], P4_H);
+        }
+        OK &= check_p4_empty(P4_H);
+
         printf("The array is %sOK!\n", (OK ? "" : "NOT "));
 
+        return OK ? 0 : 1;
+
 }
@@ -0,0 +1,175 @@
+/*
+ *     cqueue.c
+
+ *     Authors: Austin Chang achang14, Tanner Vales tvales01
+ *     Date:    9/25/2025
+ *
+ *     Bounded concurrent queue declared in queue.h, built on C11
+ *     atomics (this file is compiled with -std=c11; see the Makefile)
+ *
+ *     SPSCQ_T is a ring with one producer index and one consumer index;
+ *     each side only ever writes its own index, so both operations are
+ *     wait-free.
+ *
+ *     Capacities are rounded up to a power of two. The two indices are
+ *     padded apart so the producer and consumer do not share a cache
+ *     line. The client is responsible for freeing the elements.
+ * 
+ */
+
+#include "queue.h"
+#include "mem.h"
+#include "assert.h"
+
+#include <stdatomic.h>
+#include <stddef.h>
+
+/* Bytes between the fields that different threads write */
+#define CACHE_LINE 64
+
+/* SPSCQ_T: elems[tail & mask] is the next free slot, elems[head & mask]
+ * the next full one; tail - head is the length. head_cache and
+ * tail_cache are each side's last view of the other's index. */
+struct SPSCQ_T {
+        size_t mask;
+        void **elems;
+        char pad0[CACHE_LINE];
+        atomic_size_t head;             /* written by the consumer */
+        size_t tail_cache;
+        char pad1[CACHE_LINE];
+        atomic_size_t tail;             /* written by the producer */
+        size_t head_cache;
+        char pad2[CACHE_LINE];
+};
+
+/********** round_capacity (static helper) ********
+ *
+ * Return the smallest power of two >= capacity (and >= 2)
+ * 
+ ************************/
+static size_t round_capacity(int capacity)
+{
+        size_t n = 2;
+        while (n < (size_t)capacity) {
+                n *= 2;
+        }
+        return n;
+}
+
+/********** SPSCQ_new ********
+ *
+ * Allocates and returns an empty single-producer/single-consumer queue
+ * 
+ * Parameters:
+ *      int capacity: the most elements it holds (rounded up to a power
+ *                    of two)
+ *
+ * Return:
+ *      the SPSCQ_T that is created
+ *
+ * Notes:
+ *      CRE if capacity <= 0
+ * 
+ ************************/
+SPSCQ_T SPSCQ_new(int capacity)
+{
+        assert(capacity > 0);
+
+        SPSCQ_T queue;
+        NEW(queue);
+        size_t n = round_capacity(capacity);
+
+        queue->mask = n - 1;
+        queue->elems = ALLOC((long)(n * sizeof(void *)));
+        atomic_init(&queue->head, 0);
+        atomic_init(&queue->tail, 0);
+        queue->head_cache = 0;
+        queue->tail_cache = 0;
+
+        return queue;
+}
+
+/********** SPSCQ_try_enq ********
+ *
+ * Enqueues elem unless the queue is full. Producer thread only.
+ * 
+ * Parameters:
+ *      SPSCQ_T queue: the queue to use
+ *      void *elem:    the element to enqueue
+ *
+ * Return:
+ *      true if elem was enqueued, false if the queue was full
+ *
+ * Notes:
+ *      CRE if queue is null
+ * 
+ ************************/
+bool SPSCQ_try_enq(SPSCQ_T queue, void *elem)
+{
+        assert(queue != NULL);
+        size_t tail = atomic_load_explicit(&queue->tail,
+                                           memory_order_relaxed);
+
+        if (tail - queue->head_cache > queue->mask) {
+                queue->head_cache = atomic_load_explicit(&queue->head,
+                                                memory_order_acquire);
+                if (tail - queue->head_cache > queue->mask) {
+                        return false;
+                }
+        }
+
+        queue->elems[tail & queue->mask] = elem;
+        atomic_store_explicit(&queue->tail, tail + 1, memory_order_release);
+        return true;
+}
+
+/********** SPSCQ_try_deq ********
+ *
+ * Dequeues the front element unless the queue is empty. Consumer
+ * thread only.
+ * 
+ * Parameters:
+ *      SPSCQ_T queue: the queue to dequeue
+ *      void **elem:   receives the element
+ *
+ * Return:
+ *      true if an element was dequeued, false if the queue was empty
+ *
+ * Notes:
+ *      CRE if queue or elem is null
+ * 
+ ************************/
+bool SPSCQ_try_deq(SPSCQ_T queue, void **elem)
+{
+        assert(queue != NULL && elem != NULL);
+        size_t head = atomic_load_explicit(&queue->head,
+                                           memory_order_relaxed);
+
+        if (head == queue->tail_cache) {
+                queue->tail_cache = atomic_load_explicit(&queue->tail,
+                                                memory_order_acquire);
+                if (head == queue->tail_cache) {
+                        return false;
+                }
+        }
+
+        *elem = queue->elems[head & queue->mask];
+        atomic_store_explicit(&queue->head, head + 1, memory_order_release);
+        return true;
+}
+
+/********** SPSCQ_free ********
+ *
+ * Frees the queue; no other thread may still be using it
+ * 
+ * Notes:
+ *      CRE if queue or *queue is null
+ *      does NOT free the elements still stored in the queue
+ * 
+ ************************/
+void SPSCQ_free(SPSCQ_T *queue)
+{
+        assert(queue != NULL && *queue != NULL);
+        FREE((*queue)->elems);
+        FREE(*queue);
+}
@@ -0,0 +1,440 @@
+/**************************************************************
+ *
+ *                       deque.c
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    <tvales01>
+ *     Date:       <2025-09-25>
+ *
+ *     Chase-Lev work-stealing deque and the Sched_run scheduler, built
+ *     on C11 atomics (this file is compiled with -std=c11; see the
+ *     Makefile). The deque follows the C11 formulation of Le, Pop,
+ *     Cohen and Zappa Nardelli (PPoPP 2013).
+ *
+ *     Representation invariant (Deque_T):
+ *       Items are array->items[i & array->mask] for top <= i < bottom.
+ *       Only the owner writes bottom or replaces array; thieves and a
+ *       popping owner race for the last item by advancing top with
+ *       compare-and-swap. A grown-out array may still be read by a
+ *       thief, so it is kept on the retired list until Deque_free.
+ *
+ *     Termination (Sched_run):
+ *       idle counts workers that hold no item. A worker leaves the
+ *       count before it tries to steal and rejoins if the steal fails,
+ *       so idle == nworkers means no worker holds an item and every
+ *       deque is empty: nothing can create more work.
+ *
+ *     Checked runtime errors (CREs):
+ *       NULL handles; hint < 0; nworkers < 1; nseeds < 0; NULL task.
+ *
+ **************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stddef.h>
+
+#include "deque.h"
+#include "assert.h"
+#include "mem.h"
+
+/* Bytes between the fields that different threads write */
+#define CACHE_LINE 64
+
+/* Smallest deque buffer, in items */
+#define DEQUE_MIN 64
+
+struct Array {
+        long mask;              /* capacity - 1; capacity is 2^k */
+        struct Array *retired;  /* older, smaller arrays */
+        atomic_long items[];
+};
+
+struct Deque_T {
+        atomic_long top;
+        char pad0[CACHE_LINE];
+        atomic_long bottom;
+        _Atomic(struct Array *) array;
+        char pad1[CACHE_LINE];
+};
+
+struct Sched_T {
+        int worker;
+        int nworkers;
+        Deque_T deque;
+        struct Sched_T *all;    /* every worker, for stealing */
+        atomic_int *idle;
+        Sched_task *task;
+        void *cl;
+};
+
+/********** new_array (static helper) ********
+ * Return an array of capacity items (a power of two) whose retired
+ * list is retired.
+ ************************/
+static struct Array *new_array(long capacity, struct Array *retired)
+{
+        struct Array *array = ALLOC((long)sizeof(struct Array)
+                                    + capacity * (long)sizeof(atomic_long));
+        array->mask = capacity - 1;
+        array->retired = retired;
+        return array;
+}
+
+/********** Deque_new ********
+ * Create an empty deque with room for about hint items before it
+ * first grows.
+ *
+ * CRE
+ *      CRE if hint < 0
+ ************************/
+Deque_T Deque_new(int hint)
+{
+        assert(hint >= 0);
+
+        long capacity = DEQUE_MIN;
+        while (capacity < hint) {
+                capacity *= 2;
+        }
+
+        Deque_T deque;
+        NEW(deque);
+        atomic_init(&deque->top, 0);
+        atomic_init(&deque->bottom, 0);
+        atomic_init(&deque->array, new_array(capacity, NULL));
+
+        return deque;
+}
+
+/********** Deque_free ********
+ * Free the deque, its array and every retired array; set *deque to
+ * NULL. No other thread may still be using it.
+ *
+ * CRE
+ *      CRE if deque == NULL or *deque == NULL
+ ************************/
+void Deque_free(Deque_T *deque)
+{
+        assert(deque != NULL && *deque != NULL);
+
+        struct Array *array = atomic_load_explicit(&(*deque)->array,
+                                                   memory_order_relaxed);
+        while (array != NULL) {
+                struct Array *retired = array->retired;
+                FREE(array);
+                array = retired;
+        }
+        FREE(*deque);
+}
+
+/********** Deque_length ********
+ * Return the number of items; only a hint while other threads are
+ * stealing or the owner is pushing.
+ *
+ * CRE
+ *      CRE if deque == NULL
+ ************************/
+long Deque_length(Deque_T deque)
+{
+        assert(deque != NULL);
+
+        long bottom = atomic_load_explicit(&deque->bottom,
+                                           memory_order_relaxed);
+        long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+        return bottom > top ? bottom - top : 0;
+}
+
+/********** grow (static helper) ********
+ * Owner only: replace the array by one twice the size holding the
+ * same items top .. bottom - 1, retiring the old one.
+ ************************/
+static struct Array *grow(Deque_T deque, struct Array *old, long top,
+                          long bottom)
+{
+        struct Array *array = new_array(2 * (old->mask + 1), old);
+
+        for (long i = top; i < bottom; i++) {
+                long item = atomic_load_explicit(&old->items[i & old->mask],
+                                                 memory_order_relaxed);
+                atomic_store_explicit(&array->items[i & array->mask], item,
+                                      memory_order_relaxed);
+        }
+        atomic_store_explicit(&deque->array, array, memory_order_release);
+        return array;
+}
+
+/********** Deque_push ********
+ * Owner only: add item at the bottom, growing the buffer if full.
+ *
+ * CRE
+ *      CRE if deque == NULL
+ ************************/
+void Deque_push(Deque_T deque, long item)
+{
+        assert(deque != NULL);
+
+        long bottom = atomic_load_explicit(&deque->bottom,
+                                           memory_order_relaxed);
+        long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+        struct Array *array = atomic_load_explicit(&deque->array,
+                                                   memory_order_relaxed);
+
+        if (bottom - top > array->mask) {
+                array = grow(deque, array, top, bottom);
+        }
+        atomic_store_explicit(&array->items[bottom & array->mask], item,
+                              memory_order_relaxed);
+        atomic_thread_fence(memory_order_release);
+        atomic_store_explicit(&deque->bottom, bottom + 1,
+                              memory_order_relaxed);
+}
+
+/********** Deque_pop ********
+ * Owner only: remove the bottom (most recently pushed) item.
+ *
+ * Parameters:
+ *      Deque_T deque: the owner's deque
+ *      long *item:    receives the item
+ *
+ * Returns:
+ *      true if an item was removed, false if the deque was empty (or
+ *      a thief took the last item first)
+ *
+ * CRE
+ *      CRE if deque == NULL or item == NULL
+ ************************/
+bool Deque_pop(Deque_T deque, long *item)
+{
+        assert(deque != NULL && item != NULL);
+
+        long bottom = atomic_load_explicit(&deque->bottom,
+                                           memory_order_relaxed) - 1;
+        struct Array *array = atomic_load_explicit(&deque->array,
+                                                   memory_order_relaxed);
+        atomic_store_explicit(&deque->bottom, bottom, memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        long top = atomic_load_explicit(&deque->top, memory_order_relaxed);
+        bool found = true;
+
+        if (top <= bottom) {
+                *item = atomic_load_explicit(&array->items[bottom
+                                                           & array->mask],
+                                             memory_order_relaxed);
+                if (top == bottom) {
+                        /* last item: race the thieves for it */
+                        found = atomic_compare_exchange_strong_explicit(
+                                        &deque->top, &top, top + 1,
+                                        memory_order_seq_cst,
+                                        memory_order_relaxed);
+                        atomic_store_explicit(&deque->bottom, bottom + 1,
+                                              memory_order_relaxed);
+                }
+        }
+        else {
+                found = false;
+                atomic_store_explicit(&deque->bottom, bottom + 1,
+                                      memory_order_relaxed);
+        }
+
+        return found;
+}
+
+/********** Deque_steal ********
+ * Any thread: remove the top (oldest) item.
+ *
+ * Parameters:
+ *      Deque_T deque: another worker's deque
+ *      long *item:    receives the item
+ *
+ * Returns:
+ *      true if an item was removed; false if the deque was empty or
+ *      another thread won the race for the top item
+ *
+ * CRE
+ *      CRE if deque == NULL or item == NULL
+ ************************/
+bool Deque_steal(Deque_T deque, long *item)
+{
+        assert(deque != NULL && item != NULL);
+
+        long top = atomic_load_explicit(&deque->top, memory_order_acquire);
+        atomic_thread_fence(memory_order_seq_cst);
+        long bottom = atomic_load_explicit(&deque->bottom,
+                                           memory_order_acquire);
+
+        if (top >= bottom) {
+                return false;
+        }
+
+        struct Array *array = atomic_load_explicit(&deque->array,
+                                                   memory_order_acquire);
+        long stolen = atomic_load_explicit(&array->items[top & array->mask],
+                                           memory_order_relaxed);
+        if (!atomic_compare_exchange_strong_explicit(&deque->top, &top,
+                                                     top + 1,
+                                                     memory_order_seq_cst,
+                                                     memory_order_relaxed)) {
+                return false;
+        }
+
+        *item = stolen;
+        return true;
+}
+
+/********** Sched_spawn ********
+ * From inside a task: queue item on the calling worker's own deque.
+ *
+ * CRE
+ *      CRE if sched == NULL
+ ************************/
+void Sched_spawn(Sched_T sched, long item)
+{
+        assert(sched != NULL);
+        Deque_push(sched->deque, item);
+}
+
+/********** Sched_worker ********
+ * Return the index (0 .. nworkers - 1) of the worker running a task.
+ *
+ * CRE
+ *      CRE if sched == NULL
+ ************************/
+int Sched_worker(Sched_T sched)
+{
+        assert(sched != NULL);
+        return sched->worker;
+}
+
+/********** steal_one (static helper) ********
+ * Idle worker: try every other worker's deque once, starting after
+ * its own. On success leaves the idle count, having taken an item.
+ * Returns false, still counted idle, if nothing was stolen.
+ ************************/
+static bool steal_one(Sched_T self, long *item)
+{
+        for (int k = 1; k < self->nworkers; k++) {
+                Deque_T victim = self->all[(self->worker + k)
+                                           % self->nworkers].deque;
+
+                if (Deque_length(victim) == 0) {
+                        continue;
+                }
+                atomic_fetch_sub(self->idle, 1);
+                if (Deque_steal(victim, item)) {
+                        return true;
+                }
+                atomic_fetch_add(self->idle, 1);
+        }
+        return false;
+}
+
+/********** work (thread body) ********
+ * Run tasks from the worker's own deque, then steal, until every
+ * worker is idle.
+ ************************/
+static void *work(void *arg)
+{
+        Sched_T self = arg;
+        long item;
+
+        for (;;) {
+                while (Deque_pop(self->deque, &item)) {
+                        self->task(self, item, self->cl);
+                }
+
+                atomic_fetch_add(self->idle, 1);
+                for (;;) {
+                        if (atomic_load(self->idle) == self->nworkers) {
+                                return NULL;
+                        }
+                        if (steal_one(self, &item)) {
+                                break;
+                        }
+                        sched_yield();
+                }
+                self->task(self, item, self->cl);
+        }
+}
+
+/********** Sched_run ********
+ * Run task on every seed and on everything the tasks spawn, using
+ * nworkers threads (the caller is worker 0) with work stealing.
+ *
+ * Parameters:
+ *      int nworkers:      worker count (>= 1)
+ *      const long *seeds: nseeds initial items, dealt round-robin
+ *      Sched_task *task:  called as task(sched, item, cl); may call
+ *                         Sched_spawn(sched, ...)
+ *      void *cl:          closure passed through
+ *
+ * Effects:
+ *      Returns when no work remains. Tasks run concurrently on
+ *      different items; order is unspecified. If a thread cannot be
+ *      created, its seeds go to worker 0.
+ *
+ * CRE
+ *      CRE if nworkers < 1, nseeds < 0, seeds == NULL while
+ *      nseeds > 0, or task == NULL
+ ************************/
+void Sched_run(int nworkers, const long *seeds, long nseeds,
+               Sched_task *task, void *cl)
+{
+        assert(nworkers >= 1 && nseeds >= 0 && task != NULL);
+        assert(nseeds == 0 || seeds != NULL);
+
+        struct Sched_T *workers = CALLOC(nworkers, sizeof(*workers));
+        pthread_t *threads = CALLOC(nworkers, sizeof(*threads));
+        char *started = CALLOC(nworkers, sizeof(*started));
+        atomic_int idle;
+        atomic_init(&idle, 0);
+
+        for (int w = 0; w < nworkers; w++) {
+                workers[w].worker = w;
+                workers[w].nworkers = nworkers;
+                workers[w].deque = Deque_new(nseeds / nworkers + 1);
+                workers[w].all = workers;
+                workers[w].idle = &idle;
+                workers[w].task = task;
+                workers[w].cl = cl;
+        }
+        for (long i = 0; i < nseeds; i++) {
+                Deque_push(workers[i % nworkers].deque, seeds[i]);
+        }
+
+        for (int w = 1; w < nworkers; w++) {
+                started[w] = pthread_create(&threads[w], NULL, work,
+                                            &workers[w]) == 0;
+        }
+
+        /*
+         * A worker whose thread never started hands its seeds to
+         * worker 0 and counts as idle. Worker 0 is not idle yet, so
+         * nobody can see idle == nworkers while this runs.
+         */
+        for (int w = 1; w < nworkers; w++) {
+                long item;
+
+                if (started[w]) {
+                        continue;
+                }
+                while (Deque_pop(workers[w].deque, &item)) {
+                        Deque_push(workers[0].deque, item);
+                }
+                atomic_fetch_add(&idle, 1);
+        }
+        work(&workers[0]);
+        for (int w = 1; w < nworkers; w++) {
+                if (started[w]) {
+                        pthread_join(threads[w], NULL);
+                }
+        }
+
+        for (int w = 0; w < nworkers; w++) {
+                Deque_free(&workers[w].deque);
+        }
+        FREE(started);
+        FREE(threads);
+        FREE(workers);
+}
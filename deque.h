@@ -0,0 +1,50 @@
+/**************************************************************
+ *
+ *                       deque.h
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    <tvales01>
+ *     Date:       <2025-09-25>
+ *
+ *     Work-stealing deque (Chase-Lev) of long items, and a small
+ *     scheduler that runs a task on every item across worker threads.
+ *
+ *     Deque_T: one owner thread pushes and pops at the bottom (LIFO);
+ *     any other thread may steal from the top (FIFO). The owner never
+ *     blocks; push grows the buffer as needed. Items are plain longs
+ *     (e.g. a packed pixel index) so nothing is allocated per item.
+ *
+ *     Sched_run: each worker owns a deque, seeded round-robin. A
+ *     worker runs tasks from its own deque and, when that is empty,
+ *     steals from the others. A task adds work with Sched_spawn on the
+ *     Sched_T it was given. Sched_run returns once every deque is
+ *     empty and every task has returned.
+ *
+ *     Function contracts are documented in deque.c.
+ *
+ **************************************************************/
+
+#ifndef DEQUE_INCLUDED
+#define DEQUE_INCLUDED
+
+#include <stdbool.h>
+
+typedef struct Deque_T *Deque_T;
+
+extern Deque_T Deque_new(int hint);
+extern void Deque_free(Deque_T *deque);
+
+extern long Deque_length(Deque_T deque);
+extern void Deque_push(Deque_T deque, long item);
+extern bool Deque_pop(Deque_T deque, long *item);
+extern bool Deque_steal(Deque_T deque, long *item);
+
+typedef struct Sched_T *Sched_T;
+typedef void Sched_task(Sched_T sched, long item, void *cl);
+
+extern void Sched_run(int nworkers, const long *seeds, long nseeds,
+                      Sched_task *task, void *cl);
+extern void Sched_spawn(Sched_T sched, long item);
+extern int Sched_worker(Sched_T sched);
+
+#endif
@@ -0,0 +1,69 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "deque.h"
+
+const int COUNT = 1000;
+const int WORKERS = 4;
+
+/* Sched_run test: every item n < TREE spawns 2n + 1 and 2n + 2 */
+#define TREE 100000
+
+struct tally {
+        pthread_mutex_t lock;
+        long visits;
+        long sum;
+};
+
+void visit(Sched_T sched, long item, void *cl)
+{
+        struct tally *t = cl;
+
+        pthread_mutex_lock(&t->lock);
+        t->visits++;
+        t->sum += item;
+        pthread_mutex_unlock(&t->lock);
+
+        if (2 * item + 1 < TREE) {
+                Sched_spawn(sched, 2 * item + 1);
+        }
+        if (2 * item + 2 < TREE) {
+                Sched_spawn(sched, 2 * item + 2);
+        }
+}
+
+int main(int argc, char *argv[])
+{
+        (void)argc;
+        (void)argv;
+
+        bool OK = true;
+        Deque_T deque = Deque_new(0);
+        long item;
+
+        /* grows past its first buffer; pop is LIFO, steal is FIFO */
+        for (long i = 0; i < COUNT; i++) {
+                Deque_push(deque, i);
+        }
+        OK &= Deque_length(deque) == COUNT;
+        OK &= Deque_steal(deque, &item) && item == 0;
+        OK &= Deque_pop(deque, &item) && item == COUNT - 1;
+        for (long i = 1; i < COUNT - 1; i++) {
+                OK &= Deque_steal(deque, &item) && item == i;
+        }
+        OK &= !Deque_pop(deque, &item) && !Deque_steal(deque, &item);
+        OK &= Deque_length(deque) == 0;
+        Deque_free(&deque);
+        OK &= deque == NULL;
+
+        struct tally t = { PTHREAD_MUTEX_INITIALIZER, 0, 0 };
+        long seed = 0;
+        Sched_run(WORKERS, &seed, 1, visit, &t);
+        OK &= t.visits == TREE && t.sum == (long)TREE * (TREE - 1) / 2;
+
+        printf("The deque is %sOK!\n", (OK ? "" : "NOT "));
+
+        return OK ? 0 : 1;
+}
@@ -0,0 +1,40 @@
+#!/bin/sh
+#
+#                       pipeline_test.sh
+#
+#     Runs unblackedges --batch --pipeline over the test*.pbm files and
+#     checks every output against its answer*.pbm, three times:
+#       - with all stage threads;
+#       - with no stage thread, so the batch falls back to run_batch;
+#       - with only the writer thread, so the reader never starts.
+#     The last two starve pthread_create: thread stacks default to the
+#     stack limit, so a 1 GB stack limit under a capped address space
+#     leaves room for no thread stack, or for exactly one.
+#
+#     Usage: make pipeline_test (or sh pipeline_test.sh after make)
+#
+
+OUT=pipeline_test.tmp
+OK=1
+
+run() {
+        rm -rf $OUT && mkdir $OUT || exit 1
+        (ulimit -s 1048576 && ulimit -v "$1" \
+         && ./unblackedges --batch=$OUT --pipeline --threads=1 \
+                test1.pbm test2.pbm test3.pbm test4.pbm test6.pbm) || OK=0
+        for i in 1 2 3 4 6; do
+                cmp -s $OUT/test$i.pbm answer$i.pbm || OK=0
+        done
+}
+
+run unlimited           # every stage thread
+run 500000              # no room for a thread stack
+run 1500000             # room for the writer's stack only
+
+rm -rf $OUT
+if [ $OK = 1 ]; then
+        echo "The pipeline is OK!"
+else
+        echo "The pipeline is NOT OK!"
+        exit 1
+fi
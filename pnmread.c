@@ -0,0 +1,385 @@
+/**************************************************************
+ *
+ *                       pnmread.c
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    <tvales01, >
+ *     Date:       <2025-09-25>
+ *
+ *     Bulk netpbm reader. The whole input is brought into memory
+ *     first: a regular file is mapped with mmap, anything else (a
+ *     pipe, a terminal) is read with fread into a growing buffer.
+ *     Parsing then runs over that buffer with no per-pixel calls.
+ *
+ *     Plain formats (P1, P2) are scanned with a 256-entry character
+ *     class table, so each byte costs one load and one branch. P1
+ *     bits are packed 64 at a time straight into Bit2 rows.
+ *
+ *     Raw formats copy packed rows. P4 rows go to Bit2_load_p4_rows,
+ *     which converts MSB-first bytes to Bit2 words 64 pixels at a
+ *     time. P5 samples are one byte, or two bytes big-endian when
+ *     maxval > 255.
+ *
+ *     Dependencies:
+ *       assert.h (Hanson), mem.h, bit2.h and bit2_fast.h, uarray2.h
+ *       and uarray2_fast.h, sys/mman.h and sys/stat.h.
+ *
+ *     Checked runtime errors (CREs):
+ *       NULL stream; input is not P1/P4 (Pnmread_bit2) or P2/P5
+ *       (Pnmread_gray); malformed header; width or height <= 0; maxval
+ *       outside 1..65535; a sample above maxval or a bit other than
+ *       0/1; input too short; read failure.
+ *
+ **************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <limits.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "pnmread.h"
+#include "bit2_fast.h"
+#include "uarray2_fast.h"
+#include "assert.h"
+#include "mem.h"
+
+/* First read size for streams that cannot be mapped */
+#define READ_CHUNK (64 * 1024)
+
+/* Character classes of the plain-format scanner */
+enum { C_OTHER = 0, C_SPACE, C_DIGIT, C_HASH };
+
+/* An input image in memory: bytes [0, length) */
+typedef struct Input {
+        const unsigned char *bytes;
+        size_t length;
+        size_t pos;
+        void *map;              /* mmap'd region, or NULL */
+        unsigned char *buffer;  /* heap buffer, or NULL */
+} Input;
+
+/* A parsed header */
+typedef struct Header {
+        char format;            /* '1', '2', '4' or '5' */
+        int width;
+        int height;
+        unsigned maxval;        /* 1 for bitmaps */
+} Header;
+
+/* Class of every byte; a constant, so concurrent readers may share it */
+static const unsigned char char_class[256] = {
+        ['0'] = C_DIGIT, ['1'] = C_DIGIT, ['2'] = C_DIGIT, ['3'] = C_DIGIT,
+        ['4'] = C_DIGIT, ['5'] = C_DIGIT, ['6'] = C_DIGIT, ['7'] = C_DIGIT,
+        ['8'] = C_DIGIT, ['9'] = C_DIGIT,
+        [' '] = C_SPACE, ['\t'] = C_SPACE, ['\n'] = C_SPACE,
+        ['\v'] = C_SPACE, ['\f'] = C_SPACE, ['\r'] = C_SPACE,
+        ['#'] = C_HASH,
+};
+
+/********** load_input (static helper) ********
+ * Bring everything left in fp into memory: mmap when fp is a regular
+ * file not yet read from, fread otherwise.
+ ************************/
+static Input load_input(FILE *fp)
+{
+        Input in = { NULL, 0, 0, NULL, NULL };
+        struct stat st;
+
+        if (fstat(fileno(fp), &st) == 0 && S_ISREG(st.st_mode)
+            && st.st_size > 0 && ftell(fp) == 0) {
+                void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE,
+                                 fileno(fp), 0);
+                if (map != MAP_FAILED) {
+                        in.map = map;
+                        in.bytes = map;
+                        in.length = st.st_size;
+                        return in;
+                }
+        }
+
+        size_t capacity = READ_CHUNK;
+        size_t got;
+        in.buffer = ALLOC(capacity);
+        while ((got = fread(in.buffer + in.length, 1,
+                            capacity - in.length, fp)) > 0) {
+                in.length += got;
+                if (in.length == capacity) {
+                        capacity *= 2;
+                        RESIZE(in.buffer, capacity);
+                }
+        }
+        assert(!ferror(fp));
+        in.bytes = in.buffer;
+
+        return in;
+}
+
+/********** release_input (static helper) ********
+ * Unmap or free what load_input set up.
+ ************************/
+static void release_input(Input *in)
+{
+        if (in->map != NULL) {
+                munmap(in->map, in->length);
+        }
+        if (in->buffer != NULL) {
+                FREE(in->buffer);
+        }
+}
+
+/********** skip_space (static helper) ********
+ * Advance past whitespace and # comments (to end of line).
+ ************************/
+static void skip_space(Input *in)
+{
+        while (in->pos < in->length) {
+                int class = char_class[in->bytes[in->pos]];
+
+                if (class == C_SPACE) {
+                        in->pos++;
+                }
+                else if (class == C_HASH) {
+                        while (in->pos < in->length
+                               && in->bytes[in->pos] != '\n') {
+                                in->pos++;
+                        }
+                }
+                else {
+                        return;
+                }
+        }
+}
+
+/********** read_number (static helper) ********
+ * Skip whitespace and comments, then parse an unsigned decimal
+ * number no larger than limit.
+ *
+ * CRE
+ *      CRE if no digit follows or the value exceeds limit
+ ************************/
+static unsigned read_number(Input *in, unsigned limit)
+{
+        skip_space(in);
+        assert(in->pos < in->length
+               && char_class[in->bytes[in->pos]] == C_DIGIT);
+
+        unsigned long n = 0;
+        do {
+                n = n * 10 + (in->bytes[in->pos++] - '0');
+                assert(n <= limit);
+        } while (in->pos < in->length
+                 && char_class[in->bytes[in->pos]] == C_DIGIT);
+        (void)limit;
+
+        return (unsigned)n;
+}
+
+/********** read_header (static helper) ********
+ * Parse "Pn width height [maxval]" and, for raw formats, the single
+ * whitespace byte that separates the header from the samples.
+ *
+ * CRE
+ *      CRE if the magic is not one of formats, or on a bad field
+ ************************/
+static Header read_header(Input *in, const char *formats)
+{
+        Header h;
+
+        assert(in->length >= 2 && in->bytes[0] == 'P');
+        h.format = (char)in->bytes[1];
+        assert(h.format != '\0' && strchr(formats, h.format) != NULL);
+        (void)formats;
+        in->pos = 2;
+
+        h.width = (int)read_number(in, INT_MAX);
+        h.height = (int)read_number(in, INT_MAX);
+        assert(h.width > 0 && h.height > 0);
+        h.maxval = 1;
+        if (h.format == '2' || h.format == '5') {
+                h.maxval = read_number(in, 65535);
+                assert(h.maxval > 0);
+        }
+
+        if (h.format == '4' || h.format == '5') {
+                assert(in->pos < in->length
+                       && char_class[in->bytes[in->pos]] == C_SPACE);
+                in->pos++;
+        }
+
+        return h;
+}
+
+/********** read_plain_bits (static helper) ********
+ * P1 samples: one '0' or '1' per pixel, whitespace optional between
+ * them. Bits are gathered into a word and stored a word at a time.
+ ************************/
+static void read_plain_bits(Input *in, Bit2_T bit2, int width, int height)
+{
+        const unsigned char *bytes = in->bytes;
+        size_t pos = in->pos;
+        size_t length = in->length;
+
+        for (int row = 0; row < height; row++) {
+                uint64_t *words = Bit2_row_fast(bit2, row);
+                uint64_t word = 0;
+
+                for (int col = 0; col < width; col++) {
+                        while (pos < length
+                               && char_class[bytes[pos]] != C_DIGIT) {
+                                if (char_class[bytes[pos]] == C_HASH) {
+                                        in->pos = pos;
+                                        skip_space(in);
+                                        pos = in->pos;
+                                        continue;
+                                }
+                                assert(char_class[bytes[pos]] == C_SPACE);
+                                pos++;
+                        }
+                        assert(pos < length);
+                        assert(bytes[pos] == '0' || bytes[pos] == '1');
+
+                        word |= (uint64_t)(bytes[pos++] - '0')
+                                << (col % BIT2_WORD_BITS);
+                        if (col % BIT2_WORD_BITS == BIT2_WORD_BITS - 1
+                            || col == width - 1) {
+                                words[col / BIT2_WORD_BITS] = word;
+                                word = 0;
+                        }
+                }
+        }
+
+        in->pos = pos;
+}
+
+/********** read_raw_bits (static helper) ********
+ * P4 samples: height rows of (width + 7) / 8 bytes, MSB first, handed
+ * to Bit2_load_p4_rows to convert a word at a time.
+ ************************/
+static void read_raw_bits(Input *in, Bit2_T bit2, int width, int height)
+{
+        size_t row_bytes = ((size_t)width + 7) / 8;
+
+        assert((in->length - in->pos) / height >= row_bytes);
+        Bit2_load_p4_rows(bit2, in->bytes + in->pos);
+        in->pos += row_bytes * height;
+}
+
+/********** Pnmread_bit2 ********
+ * Read a whole P1 or P4 bitmap.
+ *
+ * Parameters:
+ *      FILE *fp: open stream at the start of the image
+ *
+ * Returns:
+ *      Bit2_T: new bitmap, 1 = black; the caller frees it
+ *
+ * Effects:
+ *      Consumes fp to end of file.
+ *
+ * CRE
+ *      CRE if fp == NULL, the input is not a P1/P4 bitmap, or it is
+ *      malformed or short (see top of file)
+ ************************/
+Bit2_T Pnmread_bit2(FILE *fp)
+{
+        return Pnmread_bit2_into(fp, NULL);
+}
+
+/********** Pnmread_bit2_into ********
+ * As Pnmread_bit2, but reads into bit2 when it is not NULL, reshaping
+ * it to the image's dimensions (see Bit2_reshape), and returns it.
+ * When bit2 is NULL a new Bit2_T is allocated and returned.
+ *
+ * CRE
+ *      As Pnmread_bit2
+ ************************/
+Bit2_T Pnmread_bit2_into(FILE *fp, Bit2_T bit2)
+{
+        assert(fp != NULL);
+
+        Input in = load_input(fp);
+        Header h = read_header(&in, "14");
+
+        if (bit2 == NULL) {
+                bit2 = Bit2_new(h.width, h.height);
+        }
+        else {
+                Bit2_reshape(bit2, h.width, h.height);
+        }
+
+        if (h.format == '1') {
+                read_plain_bits(&in, bit2, h.width, h.height);
+        }
+        else {
+                read_raw_bits(&in, bit2, h.width, h.height);
+        }
+
+        release_input(&in);
+        return bit2;
+}
+
+/********** Pnmread_gray ********
+ * Read a whole P2 or P5 graymap into ints.
+ *
+ * Parameters:
+ *      FILE *fp:              open stream at the start of the image
+ *      unsigned *denominator: if not NULL, receives the maxval
+ *
+ * Returns:
+ *      UArray2_T: new width x height array of int samples in
+ *      0..maxval; the caller frees it
+ *
+ * Effects:
+ *      Consumes fp to end of file.
+ *
+ * CRE
+ *      CRE if fp == NULL, the input is not a P2/P5 graymap, or it is
+ *      malformed or short (see top of file)
+ ************************/
+UArray2_T Pnmread_gray(FILE *fp, unsigned *denominator)
+{
+        assert(fp != NULL);
+
+        Input in = load_input(fp);
+        Header h = read_header(&in, "25");
+        UArray2_T gray = UArray2_new(h.width, h.height, sizeof(int));
+        int sample_bytes = h.maxval > 255 ? 2 : 1;
+
+        if (h.format == '5') {
+                assert((in.length - in.pos) / sample_bytes
+                       >= (size_t)h.width * h.height);
+        }
+
+        for (int row = 0; row < h.height; row++) {
+                int *samples = UArray2_at_fast(gray, 0, row);
+
+                for (int col = 0; col < h.width; col++) {
+                        unsigned v;
+
+                        if (h.format == '2') {
+                                v = read_number(&in, h.maxval);
+                        }
+                        else if (sample_bytes == 1) {
+                                v = in.bytes[in.pos++];
+                        }
+                        else {
+                                v = (unsigned)in.bytes[in.pos] << 8
+                                  | in.bytes[in.pos + 1];
+                                in.pos += 2;
+                        }
+                        assert(v <= h.maxval);
+                        samples[col] = (int)v;
+                }
+        }
+
+        if (denominator != NULL) {
+                *denominator = h.maxval;
+        }
+        release_input(&in);
+        return gray;
+}
@@ -0,0 +1,39 @@
+/**************************************************************
+ *
+ *                       pnmread.h
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    <tvales01, >
+ *     Date:       <2025-09-25>
+ *
+ *     Bulk netpbm reader: loads a whole PBM or PGM image in one go
+ *     instead of one Pnmrdr_get call per pixel.
+ *
+ *     Formats:
+ *       Pnmread_bit2: P1 (plain) or P4 (raw) bitmap into a Bit2_T.
+ *         Pnmread_bit2_into reuses an existing Bit2_T (see
+ *         Bit2_reshape) so a loop over many images need not allocate.
+ *       Pnmread_gray: P2 (plain) or P5 (raw) graymap into a UArray2_T
+ *         of int, with the maxval (denominator) reported to the caller.
+ *
+ *     Notes:
+ *       The stream must be positioned at the start of the image. It is
+ *       read (or, for a regular file, mapped) to the end; the caller
+ *       still closes it. Function contracts are documented in
+ *       pnmread.c.
+ *
+ **************************************************************/
+
+#ifndef PNMREAD_INCLUDED
+#define PNMREAD_INCLUDED
+
+#include <stdio.h>
+
+#include "bit2.h"
+#include "uarray2.h"
+
+extern Bit2_T Pnmread_bit2(FILE *fp);
+extern Bit2_T Pnmread_bit2_into(FILE *fp, Bit2_T bit2);
+extern UArray2_T Pnmread_gray(FILE *fp, unsigned *denominator);
+
+#endif
@@ -0,0 +1,220 @@
+/**************************************************************
+ *
+ *                       pnmwrite.c
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    <tvales01, >
+ *     Date:       <2025-09-25>
+ *
+ *     Buffered PBM writer. Output is formatted into a WRITE_BUFFER
+ *     byte buffer that is handed to fwrite only when full, so a whole
+ *     image costs a handful of writes instead of a printf per pixel.
+ *
+ *     Plain (P1): a row's packed words are taken a byte (8 pixels) at
+ *     a time and each byte indexes a table of its 8 digit characters,
+ *     so formatting is one 8-byte copy per 8 pixels.
+ *
+ *     Raw (P4): Bit2 words hold column i at bit i % 64 from the LSB,
+ *     while P4 wants the leftmost pixel in the MSB of each byte, so
+ *     each byte goes through a bit-reversal table. Padding bits past
+ *     width are 0 in a Bit2 and so come out as 0, as P4 requires.
+ *
+ *     Dependencies:
+ *       assert.h (Hanson), mem.h, bit2.h and bit2_fast.h.
+ *
+ *     Checked runtime errors (CREs):
+ *       NULL stream or bitmap; width or height <= 0; more rows than
+ *       height; a write error.
+ *
+ **************************************************************/
+
+#include <stddef.h>
+#include <string.h>
+
+#include "pnmwrite.h"
+#include "bit2_fast.h"
+#include "assert.h"
+#include "mem.h"
+
+/* Bytes formatted before each fwrite */
+#define WRITE_BUFFER (64 * 1024)
+
+struct Pnmwrite_T {
+        FILE *out;
+        int width;
+        int height;
+        int rows;               /* rows written so far */
+        int raw;
+        size_t used;            /* bytes of buffer filled */
+        char buffer[WRITE_BUFFER];
+};
+
+/*
+ * Per byte value c: its 8 pixels as digit characters, bit 0 first,
+ * and c with its bit order reversed. Built by the preprocessor, so the
+ * tables are constants that concurrent writers may share.
+ */
+#define DIGITS(c) { '0' + ((c) & 1), '0' + ((c) >> 1 & 1), \
+                    '0' + ((c) >> 2 & 1), '0' + ((c) >> 3 & 1), \
+                    '0' + ((c) >> 4 & 1), '0' + ((c) >> 5 & 1), \
+                    '0' + ((c) >> 6 & 1), '0' + ((c) >> 7 & 1) }
+#define REVERSED(c) (((c) & 1) << 7 | ((c) & 2) << 5 | ((c) & 4) << 3 \
+                     | ((c) & 8) << 1 | ((c) & 16) >> 1 | ((c) & 32) >> 3 \
+                     | ((c) & 64) >> 5 | ((c) & 128) >> 7)
+#define EACH4(M, c) M(c), M(c + 1), M(c + 2), M(c + 3)
+#define EACH16(M, c) EACH4(M, c), EACH4(M, c + 4), EACH4(M, c + 8), \
+                     EACH4(M, c + 12)
+#define EACH64(M, c) EACH16(M, c), EACH16(M, c + 16), EACH16(M, c + 32), \
+                     EACH16(M, c + 48)
+#define EACH256(M) EACH64(M, 0), EACH64(M, 64), EACH64(M, 128), \
+                   EACH64(M, 192)
+
+static const char digits[256][8] = { EACH256(DIGITS) };
+static const unsigned char reversed[256] = { EACH256(REVERSED) };
+
+#undef DIGITS
+#undef REVERSED
+#undef EACH4
+#undef EACH16
+#undef EACH64
+#undef EACH256
+
+/********** flush / reserve (static helpers) ********
+ * flush writes out the buffer; reserve makes room for n more bytes
+ * (n <= WRITE_BUFFER) and returns where they go.
+ ************************/
+static void flush(Pnmwrite_T writer)
+{
+        if (writer->used > 0) {
+                size_t written = fwrite(writer->buffer, 1, writer->used,
+                                        writer->out);
+                assert(written == writer->used);
+                (void)written;
+                writer->used = 0;
+        }
+}
+
+static char *reserve(Pnmwrite_T writer, size_t n)
+{
+        if (writer->used + n > WRITE_BUFFER) {
+                flush(writer);
+        }
+        char *p = writer->buffer + writer->used;
+        writer->used += n;
+        return p;
+}
+
+/********** Pnmwrite_new ********
+ * Start a PBM of width x height pixels on out and write its header.
+ *
+ * Parameters:
+ *      FILE *out:  open stream
+ *      int width:  pixels per row (> 0)
+ *      int height: rows (> 0)
+ *      int raw:    nonzero for P4, zero for P1
+ *
+ * Returns:
+ *      Pnmwrite_T: writer expecting height calls to Pnmwrite_row
+ *
+ * CRE
+ *      CRE if out == NULL or width/height <= 0
+ ************************/
+Pnmwrite_T Pnmwrite_new(FILE *out, int width, int height, int raw)
+{
+        assert(out != NULL && width > 0 && height > 0);
+
+        Pnmwrite_T writer;
+        NEW(writer);
+        writer->out = out;
+        writer->width = width;
+        writer->height = height;
+        writer->rows = 0;
+        writer->raw = raw;
+        writer->used = 0;
+
+        char header[64];
+        int n = snprintf(header, sizeof(header), "%s\n%d %d\n",
+                         raw ? "P4" : "P1", width, height);
+        memcpy(reserve(writer, n), header, n);
+
+        return writer;
+}
+
+/********** Pnmwrite_row ********
+ * Append the next row.
+ *
+ * Parameters:
+ *      Pnmwrite_T writer:    writer with rows still to come
+ *      const uint64_t *words: the row packed as in a Bit2 (bit i % 64
+ *                             of word i / 64 is column i); bits past
+ *                             width must be 0
+ *
+ * Effects:
+ *      P1: width digits and a newline. P4: (width + 7) / 8 bytes.
+ *
+ * CRE
+ *      CRE if writer or words is NULL, or height rows were already
+ *      written
+ ************************/
+void Pnmwrite_row(Pnmwrite_T writer, const uint64_t *words)
+{
+        assert(writer != NULL && words != NULL);
+        assert(writer->rows < writer->height);
+
+        int width = writer->width;
+        int nbytes = (width + 7) / 8;
+
+        for (int b = 0; b < nbytes; b++) {
+                unsigned byte = (words[b / 8] >> (8 * (b % 8))) & 0xff;
+
+                if (writer->raw) {
+                        *reserve(writer, 1) = (char)reversed[byte];
+                }
+                else {
+                        int pixels = width - 8 * b < 8 ? width - 8 * b : 8;
+                        memcpy(reserve(writer, pixels), digits[byte],
+                               pixels);
+                }
+        }
+        if (!writer->raw) {
+                *reserve(writer, 1) = '\n';
+        }
+        writer->rows++;
+}
+
+/********** Pnmwrite_free ********
+ * Flush any buffered output and free the writer; set *writer to NULL.
+ * Does not close the stream.
+ *
+ * CRE
+ *      CRE if writer or *writer is NULL, or on a write error
+ ************************/
+void Pnmwrite_free(Pnmwrite_T *writer)
+{
+        assert(writer != NULL && *writer != NULL);
+        flush(*writer);
+        int rc = fflush((*writer)->out);
+        assert(rc == 0);
+        (void)rc;
+        FREE(*writer);
+}
+
+/********** Pnmwrite_bit2 ********
+ * Write a whole bitmap as P1 (raw == 0) or P4 (raw != 0).
+ *
+ * CRE
+ *      CRE if out or bit2 is NULL, bit2 is empty, or on a write error
+ ************************/
+void Pnmwrite_bit2(FILE *out, Bit2_T bit2, int raw)
+{
+        assert(bit2 != NULL);
+
+        int height = Bit2_height(bit2);
+        Pnmwrite_T writer = Pnmwrite_new(out, Bit2_width(bit2), height, raw);
+
+        for (int row = 0; row < height; row++) {
+                Pnmwrite_row(writer, Bit2_row_fast(bit2, row));
+        }
+
+        Pnmwrite_free(&writer);
+}
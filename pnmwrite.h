@@ -0,0 +1,40 @@
+/**************************************************************
+ *
+ *                       pnmwrite.h
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    <tvales01, >
+ *     Date:       <2025-09-25>
+ *
+ *     Buffered PBM writer. Emits plain P1 (0/1 digits, newline at the
+ *     end of each row, as unblackedges has always printed) or raw P4
+ *     (packed MSB-first bytes, 8 pixels per byte).
+ *
+ *     Usage:
+ *       Pnmwrite_bit2 writes a whole Bit2_T. For images produced a row
+ *       at a time, Pnmwrite_new writes the header, Pnmwrite_row takes
+ *       each row as packed Bit2 words (see bit2_fast.h), and
+ *       Pnmwrite_free flushes.
+ *
+ *     Notes:
+ *       Function contracts are documented in pnmwrite.c.
+ *
+ **************************************************************/
+
+#ifndef PNMWRITE_INCLUDED
+#define PNMWRITE_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "bit2.h"
+
+typedef struct Pnmwrite_T *Pnmwrite_T;
+
+extern Pnmwrite_T Pnmwrite_new(FILE *out, int width, int height, int raw);
+extern void Pnmwrite_row(Pnmwrite_T writer, const uint64_t *words);
+extern void Pnmwrite_free(Pnmwrite_T *writer);
+
+extern void Pnmwrite_bit2(FILE *out, Bit2_T bit2, int raw);
+
+#endif
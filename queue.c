@@ -6,6 +6,10 @@
  *
  *     This is the implementation of a queue abstraction using Hanson's sequence
  *     The client is responsible for freeing the memory stored in the queue
+ *
+ *     RingQ_T is a second queue that stores fixed-size elements by value
+ *     in a growable circular buffer, so enqueueing never allocates per
+ *     element and nothing needs freeing on dequeue
  * 
  */
 
@@ -15,6 +19,7 @@
 #include "assert.h"
 
 #include <stdlib.h>
+#include <string.h>
 
 /* Queue_T is a data strucuted built on Seq_T with limited functions */
 struct Queue_T {
@@ -147,4 +152,256 @@ void Queue_free(Queue_T *queue)
         assert(queue != NULL && *queue != NULL);
         Seq_free(&(*queue)->seq);
         FREE(*queue);
-}
\ No newline at end of file
+}
+
+/* RingQ_T is a circular buffer of capacity elements of size bytes;
+ * capacity is a power of two so positions wrap with a mask. The
+ * elements are slots head .. head + length - 1, modulo capacity. */
+struct RingQ_T {
+        int size;
+        int capacity;
+        int head;
+        int length;
+        char *elems;
+};
+
+/********** RingQ_new ********
+ *
+ * Allocates, initializes, and returns a new, empty ring queue
+ * 
+ * Parameters:
+ *      int size: the size in bytes of each element
+ *      int hint: the number of elements expected; the buffer grows past it
+ *
+ * Return:
+ *      the RingQ_T that is created
+ *
+ * Notes:
+ *      CRE if size <= 0 or hint < 0
+ * 
+ ************************/
+RingQ_T RingQ_new(int size, int hint)
+{
+        assert(size > 0 && hint >= 0);
+
+        RingQ_T queue;
+        NEW(queue);
+        queue->size = size;
+        queue->capacity = 16;
+        while (queue->capacity < hint) {
+                queue->capacity *= 2;
+        }
+        queue->head = 0;
+        queue->length = 0;
+        queue->elems = ALLOC((long)queue->capacity * size);
+
+        return queue;
+}
+
+/********** RingQ_length / RingQ_empty ********
+ *
+ * Return the number of queued elements / whether there are none
+ *
+ * Notes:
+ *      CRE if queue is null
+ * 
+ ************************/
+int RingQ_length(RingQ_T queue)
+{
+        assert(queue != NULL);
+        return queue->length;
+}
+
+bool RingQ_empty(RingQ_T queue)
+{
+        assert(queue != NULL);
+        return queue->length == 0;
+}
+
+/********** grow (static helper) ********
+ *
+ * Make room for at least n more elements, doubling the buffer and
+ * moving the wrapped-around part so the queue stays contiguous modulo
+ * the new capacity
+ * 
+ ************************/
+static void grow(RingQ_T queue, int n)
+{
+        int old = queue->capacity;
+
+        if (queue->length + n <= old) {
+                return;
+        }
+
+        int capacity = old;
+        while (capacity < queue->length + n) {
+                capacity *= 2;
+        }
+        RESIZE(queue->elems, (long)capacity * queue->size);
+
+        /* the slots before head that wrapped now belong after old */
+        int wrapped = queue->head + queue->length - old;
+        if (wrapped > 0) {
+                memcpy(queue->elems + (long)old * queue->size, queue->elems,
+                       (long)wrapped * queue->size);
+        }
+        queue->capacity = capacity;
+}
+
+/********** copy_in / copy_out (static helpers) ********
+ *
+ * Copy n elements between a flat array and the ring starting at slot
+ * pos, in at most two pieces
+ * 
+ ************************/
+static void copy_in(RingQ_T queue, int pos, const char *src, int n)
+{
+        int first = queue->capacity - pos < n ? queue->capacity - pos : n;
+        long size = queue->size;
+
+        memcpy(queue->elems + pos * size, src, first * size);
+        memcpy(queue->elems, src + first * size, (n - first) * size);
+}
+
+static void copy_out(RingQ_T queue, int pos, char *dst, int n)
+{
+        int first = queue->capacity - pos < n ? queue->capacity - pos : n;
+        long size = queue->size;
+
+        memcpy(dst, queue->elems + pos * size, first * size);
+        memcpy(dst + first * size, queue->elems, (n - first) * size);
+}
+
+/********** RingQ_enq ********
+ *
+ * Copies one element to the back of the queue
+ * 
+ * Parameters:
+ *      RingQ_T queue:    the queue to use
+ *      const void *elem: points to size bytes to copy in
+ *
+ * Return:
+ *      none
+ *
+ * Notes:
+ *      CRE if queue or elem is null
+ * 
+ ************************/
+void RingQ_enq(RingQ_T queue, const void *elem)
+{
+        assert(queue != NULL && elem != NULL);
+        grow(queue, 1);
+
+        int tail = (queue->head + queue->length) & (queue->capacity - 1);
+        memcpy(queue->elems + (long)tail * queue->size, elem, queue->size);
+        queue->length++;
+}
+
+/********** RingQ_deq ********
+ *
+ * Copies the front element out and removes it from the queue
+ * 
+ * Parameters:
+ *      RingQ_T queue: the queue to dequeue
+ *      void *elem:    receives size bytes
+ *
+ * Return:
+ *      none
+ *
+ * Notes:
+ *      CRE if queue or elem is null, or if the queue is empty
+ * 
+ ************************/
+void RingQ_deq(RingQ_T queue, void *elem)
+{
+        assert(queue != NULL && elem != NULL);
+        assert(queue->length > 0);
+
+        memcpy(elem, queue->elems + (long)queue->head * queue->size,
+               queue->size);
+        queue->head = (queue->head + 1) & (queue->capacity - 1);
+        queue->length--;
+}
+
+/********** RingQ_enq_n ********
+ *
+ * Copies n elements, in order, to the back of the queue
+ * 
+ * Parameters:
+ *      RingQ_T queue:     the queue to use
+ *      const void *elems: array of n elements
+ *      int n:             number of elements (>= 0)
+ *
+ * Return:
+ *      none
+ *
+ * Notes:
+ *      CRE if queue is null, n < 0, or elems is null while n > 0
+ * 
+ ************************/
+void RingQ_enq_n(RingQ_T queue, const void *elems, int n)
+{
+        assert(queue != NULL && n >= 0);
+        if (n == 0) {
+                return;
+        }
+        assert(elems != NULL);
+        grow(queue, n);
+
+        copy_in(queue, (queue->head + queue->length) & (queue->capacity - 1),
+                elems, n);
+        queue->length += n;
+}
+
+/********** RingQ_deq_n ********
+ *
+ * Dequeues up to max elements from the front of the queue into elems
+ * 
+ * Parameters:
+ *      RingQ_T queue: the queue to dequeue
+ *      void *elems:   array with room for max elements
+ *      int max:       most elements to dequeue (>= 0)
+ *
+ * Return:
+ *      the number of elements dequeued, min(max, length)
+ *
+ * Notes:
+ *      CRE if queue is null, max < 0, or elems is null while max > 0
+ * 
+ ************************/
+int RingQ_deq_n(RingQ_T queue, void *elems, int max)
+{
+        assert(queue != NULL && max >= 0);
+        int n = queue->length < max ? queue->length : max;
+        if (n == 0) {
+                return 0;
+        }
+        assert(elems != NULL);
+
+        copy_out(queue, queue->head, elems, n);
+        queue->head = (queue->head + n) & (queue->capacity - 1);
+        queue->length -= n;
+
+        return n;
+}
+
+/********** RingQ_free ********
+ *
+ * Frees the queue and every element still in it
+ * 
+ * Parameters:
+ *      RingQ_T *queue: the queue to free; set to NULL
+ *
+ * Return:
+ *      none
+ *
+ * Notes:
+ *      CRE if queue or *queue is null
+ * 
+ ************************/
+void RingQ_free(RingQ_T *queue)
+{
+        assert(queue != NULL && *queue != NULL);
+        FREE((*queue)->elems);
+        FREE(*queue);
+}
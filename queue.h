@@ -15,4 +15,32 @@ bool Queue_empty(Queue_T queue);
 extern void Queue_enq(Queue_T queue, void *elem);
 extern void *Queue_deq(Queue_T queue);
 
+//Ring-buffer queue that copies fixed-size elements in and out by value,
+//so clients never allocate per element
+typedef struct RingQ_T *RingQ_T;
+
+extern RingQ_T RingQ_new(int size, int hint);
+extern void RingQ_free(RingQ_T *queue);
+
+extern int RingQ_length(RingQ_T queue);
+extern bool RingQ_empty(RingQ_T queue);
+
+extern void RingQ_enq(RingQ_T queue, const void *elem);
+extern void RingQ_deq(RingQ_T queue, void *elem);
+extern void RingQ_enq_n(RingQ_T queue, const void *elems, int n);
+extern int RingQ_deq_n(RingQ_T queue, void *elems, int max);
+
+//Bounded queue that is safe to share between threads (cqueue.c).
+//It holds void * elements and never block: try_enq fails when the
+//queue is full and try_deq fails when it is empty.
+
+//SPSCQ_T: exactly one enqueueing thread and one dequeueing thread;
+//every operation is wait-free
+typedef struct SPSCQ_T *SPSCQ_T;
+
+extern SPSCQ_T SPSCQ_new(int capacity);
+extern void SPSCQ_free(SPSCQ_T *queue);
+extern bool SPSCQ_try_enq(SPSCQ_T queue, void *elem);
+extern bool SPSCQ_try_deq(SPSCQ_T queue, void **elem);
+
 #endif
\ No newline at end of file
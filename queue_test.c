@@ -0,0 +1,106 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "queue.h"
+
+const int COUNT = 1000;
+const int BATCH = 7;
+
+/* Spinning threads yield so the test also finishes on one CPU */
+#define SPIN(cond) while (!(cond)) sched_yield()
+
+/* Elements the producer pushes through the concurrent queue */
+#define SHARED_COUNT 100000
+
+struct pair {
+        int a;
+        int b;
+};
+
+/* SPSC producer: enqueue 1..SHARED_COUNT in order */
+void *spsc_produce(void *cl)
+{
+        SPSCQ_T queue = cl;
+
+        for (intptr_t i = 1; i <= SHARED_COUNT; i++) {
+                SPIN(SPSCQ_try_enq(queue, (void *)i));
+        }
+        return NULL;
+}
+
+bool spsc_ok(void)
+{
+        SPSCQ_T queue = SPSCQ_new(64);
+        pthread_t producer;
+        bool ok = true;
+        void *elem;
+
+        if (pthread_create(&producer, NULL, spsc_produce, queue) != 0) {
+                return false;
+        }
+        for (intptr_t i = 1; i <= SHARED_COUNT; i++) {
+                SPIN(SPSCQ_try_deq(queue, &elem));
+                ok &= (intptr_t)elem == i;
+        }
+        pthread_join(producer, NULL);
+        ok &= !SPSCQ_try_deq(queue, &elem);
+
+        SPSCQ_free(&queue);
+        return ok;
+}
+
+int main(int argc, char *argv[])
+{
+        (void)argc;
+        (void)argv;
+
+        bool OK = true;
+        RingQ_T queue = RingQ_new(sizeof(struct pair), 0);
+        struct pair p;
+        int next_in = 0;
+        int next_out = 0;
+
+        OK &= RingQ_empty(queue) && RingQ_length(queue) == 0;
+
+        /* keep the head moving so the buffer wraps before it grows */
+        for (int round = 0; round < 50; round++) {
+                for (int k = 0; k < 3; k++, next_in++) {
+                        p = (struct pair){ next_in, -next_in };
+                        RingQ_enq(queue, &p);
+                }
+                RingQ_deq(queue, &p);
+                OK &= p.a == next_out && p.b == -next_out;
+                next_out++;
+        }
+        OK &= RingQ_length(queue) == next_in - next_out;
+
+        struct pair batch[BATCH];
+        while (next_in < COUNT) {
+                for (int k = 0; k < BATCH; k++, next_in++) {
+                        batch[k] = (struct pair){ next_in, -next_in };
+                }
+                RingQ_enq_n(queue, batch, BATCH);
+        }
+
+        int n;
+        while ((n = RingQ_deq_n(queue, batch, BATCH)) > 0) {
+                for (int k = 0; k < n; k++, next_out++) {
+                        OK &= batch[k].a == next_out
+                              && batch[k].b == -next_out;
+                }
+        }
+        OK &= next_out == next_in && RingQ_empty(queue);
+
+        RingQ_free(&queue);
+        OK &= queue == NULL;
+
+        OK &= spsc_ok();
+
+        printf("The queue is %sOK!\n", (OK ? "" : "NOT "));
+
+        return OK ? 0 : 1;
+}
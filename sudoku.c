@@ -7,18 +7,18 @@
  *     Date:       <2025-09-25>
  *
  *     Predicate program: exit(0) iff input is a solved 9×9 Sudoku.
- *     Reads a PGM (graymap) from stdin or one filename with Pnmrdr;
- *     asserts: type==gray, width==height==9, denominator==9. Loads a
- *     9×9 UArray2<int>, then verifies each row, column, and each 3×3
+ *     Reads a PGM (graymap, P2 or P5) from stdin or one filename in
+ *     bulk with pnmread; asserts: width==height==9, denominator==9.
+ *     Loads a 9×9 UArray2<int>, then verifies each row, column, and each 3×3
  *     block contains digits 1..9 exactly once. Prints nothing; exit
  *     status is the only result (0=solved, 1=not solved).
  *
  *     Dependencies:
- *       pnmrdr.h, uarray2.h, assert.h, mem.h, stdlib/stdio.
+ *       pnmread.h, uarray2.h, assert.h, mem.h, stdlib/stdio.
  *
  *     Checked runtime errors (CREs):
  *       >1 argument; file open failure; not a graymap; wrong dims or
- *       denominator; malformed data as detected by Pnmrdr.
+ *       denominator; malformed data as detected by pnmread.
  *
  **************************************************************/
 
@@ -26,7 +26,7 @@
 #include <stdlib.h>
 #include "assert.h"
 #include "mem.h"
-#include "pnmrdr.h"
+#include "pnmread.h"
 #include "uarray2.h"
 
 #define N 9
@@ -119,9 +119,9 @@ static int check_blocks(UArray2_T g)
  *      argc/argv: 0 args -> read stdin; 1 arg -> open filename
  *
  * Behavior:
- *      Uses Pnmrdr to read a graymap; asserts md.type == Pnmrdr_gray,
- *      md.width == md.height == 9, and md.denominator == 9.
- *      Reads 81 values into a 9×9 UArray2<int>; validates rows/cols/blocks.
+ *      Uses Pnmread_gray to read a graymap into a UArray2<int>; asserts
+ *      width == height == 9 and denominator == 9; validates
+ *      rows/cols/blocks.
  *
  * Returns:
  *      EXIT_SUCCESS (0) if solved; EXIT_FAILURE (1) otherwise.
@@ -144,25 +144,13 @@ int main(int argc, char *argv[])
         assert(0 && "sudoku takes at most one argument");
     }
 
-    /* Read header with Pnmrdr; assert it is a graymap with 9x9 dims and denom==9 */
-    Pnmrdr_T rdr = Pnmrdr_new(fp);
-    Pnmrdr_mapdata md = Pnmrdr_data(rdr);
+    /* Read the whole graymap (CRE if not P2/P5); assert 9x9 and denom==9 */
+    unsigned denominator;
+    UArray2_T grid = Pnmread_gray(fp, &denominator);
 
-    /* The interface defines a type field; assert it's graymap as required by spec. */
-    assert(md.type == Pnmrdr_gray);     
-    assert(md.width  == N && md.height == N);
-    assert(md.denominator == 9);
+    assert(UArray2_width(grid) == N && UArray2_height(grid) == N);
+    assert(denominator == 9);
 
-    /* Build a 9x9 grid of ints and read all pixels */
-    UArray2_T grid = UArray2_new(N, N, sizeof(int));
-    for (int j = 0; j < N; j++) {
-        for (int i = 0; i < N; i++) {
-            int val = Pnmrdr_get(rdr);  
-            *(int *)UArray2_at(grid, i, j) = val;
-        }
-    }
-
-    Pnmrdr_free(&rdr);
     if (fp != stdin) fclose(fp);
 
     /* Validate rows, columns, and 3x3 blocks */
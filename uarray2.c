@@ -6,43 +6,115 @@
  *     Authors:    <tvales01, >
  *     Date:       <2025-09-25>
  *
- *     Implementation of a 2-D unboxed array on top of Hanson UArray.
- *     Representation is an array-of-columns: an outer UArray_T of
- *     length width; each slot holds an inner UArray_T of length height
- *     with element size == size. Mapping orders match the spec.
+ *     Implementation of a 2-D unboxed array backed by one contiguous
+ *     block. Elements are stored row-major: row j starts at byte
+ *     offset j * pitch, and element (i,j) lives at
+ *     elems + j * pitch + i * size. One allocation holds every
+ *     element, so access and both maps are plain pointer arithmetic.
+ *     The struct itself is defined in uarray2_fast.h so that the
+ *     inline accessor there can reach it.
+ *
+ *     File-backed arrays (UArray2_map_file / UArray2_open) map a file
+ *     laid out as a FILE_HEADER_BYTES header followed by the element
+ *     block exactly as it is kept in memory, so elems points into the
+ *     mapping and nothing is parsed or copied on open.
+ *
+ *     Views (UArray2_view) are ordinary UArray2_T headers whose elems
+ *     points into another array's block and whose pitch is that
+ *     array's pitch, so a view's rows are not adjacent to each other
+ *     but every operation still works unchanged.
  *
  *     Dependencies:
- *       assert.h (Hanson), mem.h (NEW/FREE), uarray.h (Hanson).
+ *       assert.h (Hanson), mem.h (NEW/CALLOC/FREE),
+ *       uarray2_fast.h (representation), pthread.h and unistd.h
+ *       (UArray2_map_parallel), sys/mman.h, fcntl.h and sys/stat.h
+ *       (file-backed arrays).
  *
  *     Indices and order:
  *       i = column, j = row.
  *       Row-major: j outer (0..height-1), i inner (0..width-1).
  *       Col-major: i outer (0..width-1), j inner (0..height-1).
+ *       Row spans are contiguous (stride == size); column spans step
+ *       by pitch.
  *
  *     Representation invariant (assumed on entry; re-established on
  *     return):
  *       width >= 0; height >= 0; size > 0.
- *       UArray_size(outer_arr) == sizeof(UArray_T).
- *       For each column i: inner != NULL (unless height==0),
- *         UArray_length(inner) == height, UArray_size(inner) == size.
+ *       pitch >= width * size (bytes from one row to the next);
+ *         equality holds for arrays that own their storage.
+ *       Element (i,j) is at elems + j * pitch + i * size; elems is NULL
+ *         only when the array has no elements.
+ *       base != NULL: this is a view; base owns the storage, is not
+ *         itself a view, and map == NULL.
+ *       base == NULL, map == NULL: elems (if any) is owned heap storage.
+ *       base == NULL, map != NULL: map is a MAP_SHARED mapping of
+ *         map_bytes bytes and elems == map + FILE_HEADER_BYTES (NULL
+ *         when the array has no elements).
  *
  *     Checked runtime errors (CREs):
- *       UArray2_new: width<0 || height<0 || size<=0.
+ *       UArray2_new / UArray2_map_file: width<0 || height<0 || size<=0.
+ *       UArray2_view: window not inside the array.
+ *       UArray2_fill: NULL elem.
+ *       UArray2_copy / UArray2_transpose: NULL arrays, or shapes or
+ *         element sizes that do not match.
+ *       UArray2_map_file / UArray2_open: file cannot be opened, sized
+ *         or mapped; UArray2_map_file: file length would overflow a
+ *         long; UArray2_open: header is not a UArray2 header or does
+ *         not match the file length.
  *       UArray2_at / maps: NULL handle, OOB indices, NULL apply.
+ *       UArray2_map_parallel: UARRAY2_THREADS set but not a positive
+ *         integer.
  *       UArray2_free: NULL pointer or *ptr==NULL.
  *
  **************************************************************/
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 #include "uarray2.h"
-#include "uarray.h"
+#include "uarray2_fast.h"
 #include "assert.h"
 #include "mem.h"
 
-struct UArray2_T {
-        int width;
-        int height;
-        int size;
-        UArray_T outer_arr;
+/* Start of the element block in a file-backed array */
+#define FILE_HEADER_BYTES 64
+
+/* Leading bytes of every file-backed array */
+static const char file_magic[8] = "UARRAY2";
+
+/* On-disk header (native byte order), padded to FILE_HEADER_BYTES */
+struct file_header {
+        char magic[8];
+        uint32_t width;
+        uint32_t height;
+        uint32_t size;
+};
+
+/* UArray2_transpose stops splitting at tiles of at most this many
+ * elements per side */
+#define TRANSPOSE_TILE 16
+
+/* Bands handed out per worker thread by UArray2_map_parallel */
+#define BANDS_PER_THREAD 4
+
+/* Shared state for one UArray2_map_parallel call */
+struct band_work {
+        UArray2_T uarray2;
+        void (*apply)(int col, int row, UArray2_T a, void *p1, void *p2);
+        void *cl;
+        int band_rows;
+        pthread_mutex_t lock;
+        int next_row;           /* first row of the next band; locked */
 };
 
 /********** UArray2_new ********
@@ -54,11 +126,10 @@ struct UArray2_T {
  *      int size:  element size in bytes (> 0)
  *
  * Returns:
- *      UArray2_T: new array with uninitialized element storage
+ *      UArray2_T: new array with zero-filled element storage
  *
  * Effects:
- *      Allocates an outer UArray_T of length col, each slot holds an inner
- *      UArray_T of length row with element size `size`.
+ *      Allocates the header and a single block of row * col * size bytes.
  *
  * CRE
  *      CRE if col < 0 or row < 0 or size <= 0
@@ -73,18 +144,234 @@ UArray2_T UArray2_new(int col, int row, int size)
         uarray2->width = col;
         uarray2->height = row;
         uarray2->size = size;
-        uarray2->outer_arr = UArray_new(col, sizeof(UArray_T));
+        uarray2->pitch = (long)col * size;
+        uarray2->elems = NULL;
+        uarray2->map = NULL;
+        uarray2->map_bytes = 0;
+        uarray2->base = NULL;
+
+        /* Hanson ALLOC/CALLOC reject zero-byte requests */
+        if (col > 0 && row > 0) {
+                uarray2->elems = CALLOC(row, uarray2->pitch);
+        }
+
+        return uarray2;
+}
+
+/********** file_bytes (static helper) ********
+ * Return the length of a file-backed array of col × row elements of
+ * `size` bytes (header included), or -1 if it does not fit in a long.
+ * Each factor is checked before it is multiplied in.
+ ************************/
+static long file_bytes(long col, long row, long size)
+{
+        long limit = LONG_MAX - FILE_HEADER_BYTES;
+
+        if (col > 0 && row > limit / col) {
+                return -1;
+        }
+        long cells = col * row;
+        if (cells > 0 && size > limit / cells) {
+                return -1;
+        }
+        return FILE_HEADER_BYTES + cells * size;
+}
+
+/********** map_fd (static helper) ********
+ * Map an open file of `bytes` bytes shared and build an array header
+ * over it. Closes fd (the mapping stays valid without it). elems stays
+ * NULL when the array has no elements.
+ ************************/
+static UArray2_T map_fd(int fd, long bytes, int col, int row, int size)
+{
+        void *map = mmap(NULL, bytes, PROT_READ | PROT_WRITE, MAP_SHARED,
+                         fd, 0);
+        close(fd);
+        assert(map != MAP_FAILED);
+
+        UArray2_T uarray2;
+        NEW(uarray2);
+        uarray2->width = col;
+        uarray2->height = row;
+        uarray2->size = size;
+        uarray2->pitch = (long)col * size;
+        uarray2->elems = col > 0 && row > 0
+                       ? (char *)map + FILE_HEADER_BYTES : NULL;
+        uarray2->map = map;
+        uarray2->map_bytes = bytes;
+        uarray2->base = NULL;
+
+        return uarray2;
+}
+
+/********** UArray2_map_file ********
+ * Create a file-backed 2-D array, replacing any existing file at path.
+ *
+ * Parameters:
+ *      const char *path: file to create (or truncate)
+ *      int col, row, size: as UArray2_new
+ *
+ * Returns:
+ *      UArray2_T: new array whose elements live in the file; all
+ *      elements read as zero bytes
+ *
+ * Effects:
+ *      Writes the header, sizes the file to header + row * col * size
+ *      bytes and maps it shared. Element pages are read and written by
+ *      the OS on demand; UArray2_sync or UArray2_free flush them.
+ *
+ * CRE
+ *      CRE if path == NULL or col < 0 or row < 0 or size <= 0
+ *      CRE if the file would be too long for a long
+ *      CRE if the file cannot be created, sized, or mapped
+ ************************/
+UArray2_T UArray2_map_file(const char *path, int col, int row, int size)
+{
+        assert(path != NULL);
+        assert(col >= 0 && row >= 0 && size > 0);
 
-        for (int i = 0; i < col; i++) {
-                UArray_T inner_arr = UArray_new(row, size);
+        long bytes = file_bytes(col, row, size);
+        assert(bytes >= 0);
+        int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+        assert(fd >= 0);
 
-                UArray_T *innerp = UArray_at(uarray2->outer_arr, i);
-                *innerp = inner_arr;
+        if (ftruncate(fd, bytes) != 0) {
+                close(fd);
+                assert(0 && "cannot size UArray2 file");
         }
 
+        UArray2_T uarray2 = map_fd(fd, bytes, col, row, size);
+
+        struct file_header header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.magic, file_magic, sizeof(header.magic));
+        header.width = col;
+        header.height = row;
+        header.size = size;
+        memcpy(uarray2->map, &header, sizeof(header));
+
         return uarray2;
 }
 
+/********** UArray2_open ********
+ * Reopen an array previously created by UArray2_map_file.
+ *
+ * Parameters:
+ *      const char *path: file written by UArray2_map_file
+ *
+ * Returns:
+ *      UArray2_T: array over the file's elements; no element is read
+ *      or copied until it is used
+ *
+ * CRE
+ *      CRE if path == NULL or the file cannot be opened or mapped
+ *      CRE if the file does not start with a UArray2 header or its
+ *          length does not match the header
+ ************************/
+UArray2_T UArray2_open(const char *path)
+{
+        assert(path != NULL);
+
+        int fd = open(path, O_RDWR);
+        assert(fd >= 0);
+
+        struct stat st;
+        struct file_header header;
+        int valid = fstat(fd, &st) == 0 && st.st_size >= FILE_HEADER_BYTES
+                    && pread(fd, &header, sizeof(header), 0)
+                       == (ssize_t)sizeof(header)
+                    && memcmp(header.magic, file_magic,
+                              sizeof(header.magic)) == 0
+                    && header.width <= INT_MAX && header.height <= INT_MAX
+                    && header.size > 0 && header.size <= INT_MAX;
+
+        /* a corrupt header must not overflow the length check */
+        if (valid) {
+                long bytes = file_bytes(header.width, header.height,
+                                        header.size);
+                valid = bytes >= 0 && st.st_size == bytes;
+        }
+        if (!valid) {
+                close(fd);
+                assert(0 && "not a UArray2 file");
+        }
+
+        return map_fd(fd, st.st_size, header.width, header.height,
+                      header.size);
+}
+
+/********** UArray2_sync ********
+ * Write a file-backed array's changes out to its file now.
+ *
+ * Parameters:
+ *      UArray2_T a: non-NULL array; heap arrays are left alone, and a
+ *                   view syncs the array it is a view of
+ *
+ * CRE
+ *      CRE if a == NULL or the flush fails
+ ************************/
+void UArray2_sync(UArray2_T uarray2)
+{
+        assert(uarray2);
+
+        if (uarray2->base != NULL) {
+                uarray2 = uarray2->base;
+        }
+        if (uarray2->map != NULL) {
+                int rc = msync(uarray2->map, uarray2->map_bytes, MS_SYNC);
+                assert(rc == 0);
+                (void)rc;
+        }
+}
+
+/********** UArray2_view ********
+ * Return a view of the col × row window whose top-left element is
+ * (col0,row0). No elements are copied.
+ *
+ * Parameters:
+ *      UArray2_T a:     non-NULL array (may itself be a view)
+ *      int col0, row0:  window origin, 0 <= col0 <= width,
+ *                       0 <= row0 <= height
+ *      int col, row:    window size, col0 + col <= width,
+ *                       row0 + row <= height
+ *
+ * Returns:
+ *      UArray2_T: array whose element (i,j) is a's element
+ *      (col0 + i, row0 + j); writes through either are seen by both
+ *
+ * Notes:
+ *      The view must be freed with UArray2_free, which frees only the
+ *      view's header. It is valid until the array that owns the
+ *      storage is freed (for nested views, the outermost array).
+ *
+ * CRE
+ *      CRE if a == NULL or the window is not inside a
+ ************************/
+UArray2_T UArray2_view(UArray2_T uarray2, int col0, int row0, int col,
+                       int row)
+{
+        assert(uarray2);
+        assert(col0 >= 0 && col >= 0 && col <= uarray2->width - col0);
+        assert(row0 >= 0 && row >= 0 && row <= uarray2->height - row0);
+
+        UArray2_T view;
+        NEW(view);
+        view->width = col;
+        view->height = row;
+        view->size = uarray2->size;
+        view->pitch = uarray2->pitch;
+        view->elems = NULL;
+        if (col > 0 && row > 0) {
+                view->elems = uarray2->elems + row0 * uarray2->pitch
+                                             + (long)col0 * uarray2->size;
+        }
+        view->map = NULL;
+        view->map_bytes = 0;
+        view->base = uarray2->base != NULL ? uarray2->base : uarray2;
+
+        return view;
+}
+
 /********** UArray2_width / UArray2_height / UArray2_size ********
  * Return array dimensions and element size.
  *
@@ -135,12 +422,8 @@ void *UArray2_at(UArray2_T uarray2, int col, int row)
         assert(col >= 0 && col < uarray2->width);
         assert(row >= 0 && row < uarray2->height);
 
-        UArray_T *innerp = UArray_at(uarray2->outer_arr, col);
-        UArray_T inner = *innerp;
-        assert(sizeof(inner) == UArray_size(uarray2->outer_arr));
-        assert(UArray_size(inner) == uarray2->size);
-
-        return UArray_at(inner, row);
+        return uarray2->elems + row * uarray2->pitch
+                              + (long)col * uarray2->size;
 }
 
 /********** UArray2_map_row_major ********
@@ -167,16 +450,16 @@ void UArray2_map_row_major(UArray2_T uarray2,
                                   void *cl) 
 {
         assert(uarray2);
-        UArray_T outer_arr = uarray2->outer_arr;
+        assert(apply);
+        int size = uarray2->size;
 
         for (int row = 0; row < uarray2->height; row++) {
-                for (int col = 0; col < uarray2->width; col++) {
-                        UArray_T *innerp = UArray_at(outer_arr, col);
-                        UArray_T inner = *innerp;
-                        assert(sizeof(inner) == UArray_size(outer_arr));
-                        apply(col, row, uarray2, UArray_at(inner, row), cl);
+                char *p = uarray2->elems + row * uarray2->pitch;
+
+                for (int col = 0; col < uarray2->width; col++, p += size) {
+                        apply(col, row, uarray2, p, cl);
                 }
-        }                         
+        }
 }
 
 /********** UArray2_map_col_major ********
@@ -188,18 +471,378 @@ void UArray2_map_col_major(UArray2_T uarray2,
                                   void *cl)
 {
         assert(uarray2);
-        UArray_T outer_arr = uarray2->outer_arr;
+        assert(apply);
+        long pitch = uarray2->pitch;
 
         for (int col = 0; col < uarray2->width; col++) {
-                UArray_T *innerp = UArray_at(outer_arr, col);
-                UArray_T inner = *innerp;
-                assert(sizeof(inner) == UArray_size(outer_arr));
+                char *p = uarray2->elems + (long)col * uarray2->size;
 
-                for (int row = 0; row < uarray2->height; row++) {
-                        apply(col, row, uarray2, UArray_at(inner, row), cl);
+                for (int row = 0; row < uarray2->height; row++, p += pitch) {
+                        apply(col, row, uarray2, p, cl);
                 }
         }
+}
 
+/********** UArray2_map_row_spans ********
+ * Call apply once per row with the row's elements as one run.
+ *
+ * Parameters:
+ *      UArray2_T a: array
+ *      void apply(int row, UArray2_T a2, void *run, int length, int stride,
+ *                 void *cl):
+ *                   client callback; `run` points to element (0,row),
+ *                   `length` == width, and element k of the run is at
+ *                   (char *)run + k * stride
+ *      void *cl:    closure passed through
+ *
+ * Returns:
+ *      None
+ *
+ * Order:
+ *      Rows 0..height-1. Row runs are contiguous: stride == size.
+ *
+ * Notes:
+ *      Not called at all when width == 0, so run is never NULL.
+ *
+ * CRE
+ *      CRE if a == NULL or apply == NULL
+ ************************/
+void UArray2_map_row_spans(UArray2_T uarray2,
+                                  void apply(int row, UArray2_T a,
+                                             void *run, int length,
+                                             int stride, void *cl),
+                                  void *cl)
+{
+        assert(uarray2);
+        assert(apply);
+
+        if (uarray2->width == 0) {
+                return;
+        }
+        for (int row = 0; row < uarray2->height; row++) {
+                apply(row, uarray2, uarray2->elems + row * uarray2->pitch,
+                      uarray2->width, uarray2->size, cl);
+        }
+}
+
+/********** UArray2_map_col_spans ********
+ * Same as above but one call per column: `run` points to element
+ * (col,0), `length` == height, and stride is the row pitch in bytes.
+ ************************/
+void UArray2_map_col_spans(UArray2_T uarray2,
+                                  void apply(int col, UArray2_T a,
+                                             void *run, int length,
+                                             int stride, void *cl),
+                                  void *cl)
+{
+        assert(uarray2);
+        assert(apply);
+
+        assert(uarray2->pitch <= INT_MAX);
+
+        if (uarray2->height == 0) {
+                return;
+        }
+        for (int col = 0; col < uarray2->width; col++) {
+                apply(col, uarray2,
+                      uarray2->elems + (long)col * uarray2->size,
+                      uarray2->height, (int)uarray2->pitch, cl);
+        }
+}
+
+/********** parallel_threads (static helper) ********
+ * Choose the thread count for UArray2_map_parallel: the request if
+ * positive, else $UARRAY2_THREADS if set, else the online CPU count.
+ *
+ * CRE
+ *      CRE if UARRAY2_THREADS is set but is not a positive integer
+ ************************/
+static int parallel_threads(int nthreads)
+{
+        if (nthreads > 0) {
+                return nthreads;
+        }
+
+        const char *env = getenv("UARRAY2_THREADS");
+        if (env != NULL) {
+                char *end;
+                long n = strtol(env, &end, 10);
+                assert(end != env && *end == '\0' && n > 0 && n <= INT_MAX);
+                return (int)n;
+        }
+
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        return cpus > 0 ? (int)cpus : 1;
+}
+
+/********** map_band_worker (static helper) ********
+ * Thread body: repeatedly claim the next band of rows and apply to each
+ * of its elements in row-major order, until no rows are left.
+ ************************/
+static void *map_band_worker(void *arg)
+{
+        struct band_work *work = arg;
+        UArray2_T uarray2 = work->uarray2;
+        int size = uarray2->size;
+
+        for (;;) {
+                pthread_mutex_lock(&work->lock);
+                int first = work->next_row;
+                work->next_row += work->band_rows;
+                pthread_mutex_unlock(&work->lock);
+
+                if (first >= uarray2->height) {
+                        return NULL;
+                }
+
+                int last = uarray2->height - first < work->band_rows
+                         ? uarray2->height : first + work->band_rows;
+
+                for (int row = first; row < last; row++) {
+                        char *p = uarray2->elems + row * uarray2->pitch;
+
+                        for (int col = 0; col < uarray2->width;
+                             col++, p += size) {
+                                work->apply(col, row, uarray2, p, work->cl);
+                        }
+                }
+        }
+}
+
+/********** UArray2_map_parallel ********
+ * Visit every element, calling apply from several threads at once.
+ *
+ * Parameters:
+ *      UArray2_T a:  array
+ *      int nthreads: number of threads to use (calling thread included);
+ *                    <= 0 means $UARRAY2_THREADS if set, otherwise one
+ *                    per online CPU
+ *      void apply(int col, int row, UArray2_T a2, void *elem, void *cl):
+ *                    same callback as the sequential maps
+ *      void *cl:     closure passed through, shared by all threads
+ *
+ * Returns:
+ *      None, after every element has been visited exactly once.
+ *
+ * Order:
+ *      Rows are split into bands of consecutive rows that threads claim
+ *      on demand. Within a band, elements are visited in row-major
+ *      order; bands run concurrently in no particular order.
+ *
+ * Contract for apply:
+ *      apply may write only *elem, the element it was handed. It may
+ *      read other elements only if no call writes them. Anything it
+ *      does with cl must be safe to do from several threads at once.
+ *      apply must not raise exceptions (Hanson's Except is not
+ *      thread-safe) and must not free or resize the array.
+ *
+ * Notes:
+ *      If a thread cannot be created, the remaining work is done by the
+ *      threads that exist (at worst the calling thread alone).
+ *
+ * CRE
+ *      CRE if a == NULL or apply == NULL
+ *      CRE if nthreads <= 0 and UARRAY2_THREADS is malformed
+ ************************/
+void UArray2_map_parallel(UArray2_T uarray2, int nthreads,
+                                 void apply(int col, int row, UArray2_T a,
+                                            void *p1, void *p2),
+                                 void *cl)
+{
+        assert(uarray2);
+        assert(apply);
+
+        nthreads = parallel_threads(nthreads);
+        if (nthreads > uarray2->height) {
+                nthreads = uarray2->height > 0 ? uarray2->height : 1;
+        }
+
+        struct band_work work;
+        work.uarray2 = uarray2;
+        work.apply = apply;
+        work.cl = cl;
+        work.band_rows = uarray2->height / (nthreads * BANDS_PER_THREAD);
+        if (work.band_rows < 1) {
+                work.band_rows = 1;
+        }
+        work.next_row = 0;
+        pthread_mutex_init(&work.lock, NULL);
+
+        /* The calling thread is worker 0 */
+        pthread_t *threads = NULL;
+        int spawned = 0;
+        if (nthreads > 1) {
+                threads = ALLOC((long)(nthreads - 1) * sizeof(*threads));
+                while (spawned < nthreads - 1
+                       && pthread_create(&threads[spawned], NULL,
+                                         map_band_worker, &work) == 0) {
+                        spawned++;
+                }
+        }
+
+        map_band_worker(&work);
+
+        for (int i = 0; i < spawned; i++) {
+                pthread_join(threads[i], NULL);
+        }
+        if (threads != NULL) {
+                FREE(threads);
+        }
+        pthread_mutex_destroy(&work.lock);
+}
+
+/********** UArray2_fill ********
+ * Set every element to a copy of *elem.
+ *
+ * Parameters:
+ *      UArray2_T a:      non-NULL array (may be a view)
+ *      const void *elem: size bytes to copy into each element
+ *
+ * Effects:
+ *      Fills the first row by repeated doubling memcpy, then copies that
+ *      row into every other row.
+ *
+ * CRE
+ *      CRE if a == NULL or elem == NULL
+ ************************/
+void UArray2_fill(UArray2_T uarray2, const void *elem)
+{
+        assert(uarray2);
+        assert(elem);
+
+        if (uarray2->width == 0 || uarray2->height == 0) {
+                return;
+        }
+
+        char *first = uarray2->elems;
+        long row_bytes = (long)uarray2->width * uarray2->size;
+        long done = uarray2->size;
+
+        memcpy(first, elem, uarray2->size);
+        while (done < row_bytes) {
+                long n = done < row_bytes - done ? done : row_bytes - done;
+                memcpy(first + done, first, n);
+                done += n;
+        }
+
+        for (int row = 1; row < uarray2->height; row++) {
+                memcpy(first + row * uarray2->pitch, first, row_bytes);
+        }
+}
+
+/********** UArray2_copy ********
+ * Copy every element of src into the same position of dst.
+ *
+ * Parameters:
+ *      UArray2_T dst, src: non-NULL arrays with equal width, height and
+ *                          size; they must not share storage
+ *
+ * Effects:
+ *      One memcpy when both arrays are whole (unpadded) blocks,
+ *      otherwise one memcpy per row.
+ *
+ * CRE
+ *      CRE if dst or src is NULL or their shapes or sizes differ
+ ************************/
+void UArray2_copy(UArray2_T dst, UArray2_T src)
+{
+        assert(dst && src);
+        assert(dst->width == src->width && dst->height == src->height);
+        assert(dst->size == src->size);
+
+        long row_bytes = (long)src->width * src->size;
+
+        if (row_bytes == 0 || src->height == 0) {
+                return;
+        }
+        if (dst->pitch == row_bytes && src->pitch == row_bytes) {
+                memcpy(dst->elems, src->elems, row_bytes * src->height);
+                return;
+        }
+        for (int row = 0; row < src->height; row++) {
+                memcpy(dst->elems + row * dst->pitch,
+                       src->elems + row * src->pitch, row_bytes);
+        }
+}
+
+/********** transpose_tile (static helper) ********
+ * Transpose the src window of cols × rows elements at (col0,row0) into
+ * dst, recursively halving the longer side until the window fits in a
+ * TRANSPOSE_TILE square. The recursion keeps both the rows being read
+ * and the columns being written within cache at every scale, without
+ * knowing the cache size.
+ ************************/
+static void transpose_tile(UArray2_T dst, UArray2_T src, int col0, int row0,
+                           int cols, int rows)
+{
+        if (cols > TRANSPOSE_TILE || rows > TRANSPOSE_TILE) {
+                if (cols >= rows) {
+                        int half = cols / 2;
+                        transpose_tile(dst, src, col0, row0, half, rows);
+                        transpose_tile(dst, src, col0 + half, row0,
+                                       cols - half, rows);
+                }
+                else {
+                        int half = rows / 2;
+                        transpose_tile(dst, src, col0, row0, cols, half);
+                        transpose_tile(dst, src, col0, row0 + half,
+                                       cols, rows - half);
+                }
+                return;
+        }
+
+        int size = src->size;
+        long dpitch = dst->pitch;
+
+        for (int row = row0; row < row0 + rows; row++) {
+                const char *s = src->elems + row * src->pitch
+                                           + (long)col0 * size;
+                char *d = dst->elems + col0 * dpitch + (long)row * size;
+
+                /* constant sizes let the compiler inline the copies */
+                switch (size) {
+                case 4:
+                        for (int c = 0; c < cols; c++) {
+                                memcpy(d + c * dpitch, s + c * 4, 4);
+                        }
+                        break;
+                case 8:
+                        for (int c = 0; c < cols; c++) {
+                                memcpy(d + c * dpitch, s + c * 8, 8);
+                        }
+                        break;
+                default:
+                        for (int c = 0; c < cols; c++) {
+                                memcpy(d + c * dpitch, s + c * size, size);
+                        }
+                        break;
+                }
+        }
+}
+
+/********** UArray2_transpose ********
+ * Store the transpose of src in dst: dst(j,i) = src(i,j).
+ *
+ * Parameters:
+ *      UArray2_T dst: non-NULL, width == src height, height == src width
+ *      UArray2_T src: non-NULL, same element size as dst; must not share
+ *                     storage with dst
+ *
+ * Effects:
+ *      Cache-oblivious recursive transpose (see transpose_tile).
+ *
+ * CRE
+ *      CRE if dst or src is NULL or their shapes or sizes do not match
+ ************************/
+void UArray2_transpose(UArray2_T dst, UArray2_T src)
+{
+        assert(dst && src);
+        assert(dst->width == src->height && dst->height == src->width);
+        assert(dst->size == src->size);
+
+        if (src->width > 0 && src->height > 0) {
+                transpose_tile(dst, src, 0, 0, src->width, src->height);
+        }
 }
 
 /********** UArray2_free ********
@@ -212,7 +855,9 @@ void UArray2_map_col_major(UArray2_T uarray2,
  *      None
  *
  * Effects:
- *      Frees all inner arrays, the outer array, and the header; sets *uarray2=NULL.
+ *      Frees the element block (or unmaps the file, whose contents
+ *      persist) and the header; sets *uarray2=NULL. Freeing a view
+ *      frees only its header.
  *
  * CRE
  *      CRE if uarray2 == NULL or *uarray2 == NULL
@@ -220,10 +865,14 @@ void UArray2_map_col_major(UArray2_T uarray2,
 void UArray2_free(UArray2_T *uarray2) {
         assert(uarray2 && *uarray2);
 
-        for (int col = 0; col < (*uarray2)->width; col++) {
-                UArray_T *innerp = UArray_at((*uarray2)->outer_arr, col);
-                UArray_free(innerp);
+        /* A view's storage belongs to its base array */
+        if ((*uarray2)->base == NULL) {
+                if ((*uarray2)->map != NULL) {
+                        munmap((*uarray2)->map, (*uarray2)->map_bytes);
+                }
+                else if ((*uarray2)->elems != NULL) {
+                        FREE((*uarray2)->elems);
+                }
         }
-        UArray_free(&(*uarray2)->outer_arr);
         FREE(*uarray2);
 }
@@ -14,10 +14,27 @@
  *       i = column (0..width-1), j = row (0..height-1).
  *       Row-major map: rows outer, columns inner.
  *       Col-major map: columns outer, rows inner.
+ *       Span maps: one call per row (or column) with a pointer to its
+ *       first element, the element count, and the byte stride between
+ *       consecutive elements.
+ *       Parallel map: rows are split into bands that worker threads
+ *       visit concurrently; no order is guaranteed between bands.
  *
  *     Notes:
  *       UArray2_at returns a pointer to element storage valid until the
- *       array is freed. Function contracts are documented in uarray2.c.
+ *       array is freed. Elements live in one contiguous row-major block,
+ *       so the elements of a row are adjacent in memory.
+ *       UArray2_view returns an array that shares a rectangular window
+ *       of another array's elements; it supports every operation here
+ *       (including further views) and stays valid until the array
+ *       that owns the storage is freed.
+ *       UArray2_fill / UArray2_copy / UArray2_transpose work a row or
+ *       block at a time; copy and transpose need non-overlapping
+ *       arrays of matching shape.
+ *       Arrays made by UArray2_map_file / UArray2_open keep their
+ *       elements in a memory-mapped file; changes reach the file, and
+ *       UArray2_free unmaps it.
+ *       Function contracts are documented in uarray2.c.
  *
  **************************************************************/
 
@@ -30,6 +47,14 @@ typedef struct T *T;
 
 extern T UArray2_new(int col, int row, int size);
 
+extern T UArray2_map_file(const char *path, int col, int row, int size);
+
+extern T UArray2_open(const char *path);
+
+extern void UArray2_sync(T uarray2);
+
+extern T UArray2_view(T uarray2, int col0, int row0, int col, int row);
+
 extern int UArray2_width(T uarray2);
 
 extern int UArray2_height(T uarray2);
@@ -48,6 +73,29 @@ extern void UArray2_map_row_major(T uarray2,
                                              void *p1, void *cl),
                                   void *cl);
 
+extern void UArray2_map_row_spans(T uarray2,
+                                  void apply(int row, T uarray2, void *run,
+                                             int length, int stride,
+                                             void *cl),
+                                  void *cl);
+
+extern void UArray2_map_col_spans(T uarray2,
+                                  void apply(int col, T uarray2, void *run,
+                                             int length, int stride,
+                                             void *cl),
+                                  void *cl);
+
+extern void UArray2_map_parallel(T uarray2, int nthreads,
+                                 void apply(int col, int row, T uarray2,
+                                            void *p1, void *cl),
+                                 void *cl);
+
+extern void UArray2_fill(T uarray2, const void *elem);
+
+extern void UArray2_copy(T dst, T src);
+
+extern void UArray2_transpose(T dst, T src);
+
 extern void UArray2_free(T *uarray2);
 
 #undef T
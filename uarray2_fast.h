@@ -0,0 +1,60 @@
+/**************************************************************
+ *
+ *                       uarray2_fast.h
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    tvales01,
+ *     Date:       <2025-09-25>
+ *
+ *     Representation of UArray2_T plus an inline element accessor for
+ *     hot loops. UArray2_at_fast behaves like UArray2_at but is
+ *     expanded at the call site.
+ *
+ *     Checking:
+ *       By default the fast accessor checks the same CREs as
+ *       uarray2.c. When compiled with -DUNCHECKED_ACCESS (the release
+ *       build in the Makefile) the handle and bounds checks are
+ *       compiled out; out-of-range indices are then unchecked errors.
+ *
+ *     Notes:
+ *       Only code that needs the speed should include this header;
+ *       everything else should go through uarray2.h.
+ *
+ **************************************************************/
+
+#ifndef UARRAY2_FAST_INCLUDED
+#define UARRAY2_FAST_INCLUDED
+
+#include <stddef.h>
+
+#include "uarray2.h"
+#include "assert.h"
+
+#ifdef UNCHECKED_ACCESS
+#define UARRAY2_CHECK(e) ((void)0)
+#else
+#define UARRAY2_CHECK(e) assert(e)
+#endif
+
+struct UArray2_T {
+        int width;
+        int height;
+        int size;
+        long pitch;     /* bytes from one row to the next */
+        char *elems;    /* element (0,0); rows are pitch bytes apart */
+        void *map;      /* file mapping holding elems, or NULL if heap */
+        long map_bytes; /* length of map */
+        UArray2_T base; /* array that owns elems if a view, else NULL */
+};
+
+static inline void *UArray2_at_fast(UArray2_T uarray2, int col, int row)
+{
+        UARRAY2_CHECK(uarray2 != NULL);
+        UARRAY2_CHECK(col >= 0 && col < uarray2->width);
+        UARRAY2_CHECK(row >= 0 && row < uarray2->height);
+
+        return uarray2->elems + row * uarray2->pitch
+                              + (long)col * uarray2->size;
+}
+
+#endif
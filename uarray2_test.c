@@ -1,11 +1,170 @@
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <string.h>
+#include "assert.h"
+#include "except.h"
 #include "uarray2.h"
 
 const int DIM1 = 5;
 const int DIM2 = 7;
 const int ELEMENT_SIZE = sizeof(int);
 const int MARKER = 99;
+const char *MAP_PATH = "uarray2_test.tmp";
+
+struct visit {
+        bool ok;
+        int count;
+        int last;
+};
+
+void check_and_count(int i, int j, UArray2_T a, void *p1, void *p2)
+{
+        struct visit *v = p2;
+
+        v->ok &= UArray2_at(a, i, j) == p1;
+        if ( (i == (UArray2_width(a) - 1) )
+             && (j == (UArray2_height(a) - 1) ) ) {
+                /* we got the corner */
+                v->ok &= (*(int *)p1 == MARKER);
+        }
+        v->count++;
+}
+
+/* Row spans come in row order and cover the row contiguously */
+void check_row_span(int row, UArray2_T a, void *run, int length, int stride,
+                    void *cl)
+{
+        struct visit *v = cl;
+
+        v->ok &= row == v->last + 1 && length == UArray2_width(a)
+                 && stride == UArray2_size(a);
+        for (int k = 0; k < length; k++) {
+                v->ok &= (char *)run + k * stride == UArray2_at(a, k, row);
+        }
+        v->last = row;
+        v->count++;
+}
+
+void check_col_span(int col, UArray2_T a, void *run, int length, int stride,
+                    void *cl)
+{
+        struct visit *v = cl;
+
+        v->ok &= col == v->last + 1 && length == UArray2_height(a);
+        for (int k = 0; k < length; k++) {
+                v->ok &= (char *)run + (long)k * stride
+                         == UArray2_at(a, col, k);
+        }
+        v->last = col;
+        v->count++;
+}
+
+/* Element (i,j) holds i * 1000 + j until visited, then -1 */
+void label(int i, int j, UArray2_T a, void *p1, void *p2)
+{
+        (void)a;
+        (void)p2;
+        *(int *)p1 = i * 1000 + j;
+}
+
+/* Writes only its own element, as UArray2_map_parallel requires */
+void claim(int i, int j, UArray2_T a, void *p1, void *p2)
+{
+        (void)a;
+        (void)p2;
+        *(int *)p1 = *(int *)p1 == i * 1000 + j ? -1 : -2;
+}
+
+void check_claimed(int i, int j, UArray2_T a, void *p1, void *p2)
+{
+        struct visit *v = p2;
+
+        (void)i;
+        (void)j;
+        (void)a;
+        v->ok &= *(int *)p1 == -1;
+        v->count++;
+}
+
+/* Whether every element (i,j) holds i * 1000 + j */
+void check_labels(int i, int j, UArray2_T a, void *p1, void *p2)
+{
+        struct visit *v = p2;
+
+        (void)a;
+        v->ok &= *(int *)p1 == i * 1000 + j;
+        v->count++;
+}
+
+/* Labels seen through a window at (col0,row0) of a labelled array */
+struct window {
+        bool ok;
+        int count;
+        int col0;
+        int row0;
+};
+
+void check_window(int i, int j, UArray2_T a, void *p1, void *p2)
+{
+        struct window *w = p2;
+
+        (void)a;
+        w->ok &= *(int *)p1 == (w->col0 + i) * 1000 + (w->row0 + j);
+        w->count++;
+}
+
+/* Whether every element holds value */
+struct value {
+        bool ok;
+        int count;
+        int value;
+};
+
+void check_value(int i, int j, UArray2_T a, void *p1, void *p2)
+{
+        struct value *c = p2;
+
+        (void)i;
+        (void)j;
+        (void)a;
+        c->ok &= *(int *)p1 == c->value;
+        c->count++;
+}
+
+/* Element (i,j) of a transpose holds the label of (j,i) */
+void check_transposed(int i, int j, UArray2_T a, void *p1, void *p2)
+{
+        struct visit *v = p2;
+
+        (void)a;
+        v->ok &= *(int *)p1 == j * 1000 + i;
+        v->count++;
+}
+
+/* Whether UArray2_open rejects a file whose header claims w × h × size */
+bool open_rejects(uint32_t w, uint32_t h, uint32_t size)
+{
+        /* the header layout of uarray2.c: magic, width, height, size */
+        unsigned char file[64] = "UARRAY2";
+        memcpy(file + 8, &w, sizeof(w));
+        memcpy(file + 12, &h, sizeof(h));
+        memcpy(file + 16, &size, sizeof(size));
+
+        FILE *fp = fopen(MAP_PATH, "wb");
+        size_t wrote = fwrite(file, 1, sizeof(file), fp);
+        fclose(fp);
+
+        volatile bool rejected = false;
+        TRY
+                UArray2_T a = UArray2_open(MAP_PATH);
+                UArray2_free(&a);
+        EXCEPT(Assert_Failed)
+                rejected = true;
+        END_TRY;
+
+        return wrote == sizeof(file) && rejected;
+}
 
 int main(int argc, char *argv[])
 {
@@ -16,28 +175,199 @@ int main(int argc, char *argv[])
         bool OK = true;
 
         test_array = UArray2_new(DIM1, DIM2, ELEMENT_SIZE);
-        (void)test_array;
-        /*
+
         OK = (UArray2_width(test_array) == DIM1) &&
              (UArray2_height(test_array) == DIM2) &&
-             (UArray2_size(test_array) == ELEMENT_SIZE);*/
-
+             (UArray2_size(test_array) == ELEMENT_SIZE);
 
-        
         /* Note: we are only setting a value on the corner of the array */
-        /*
-        *((number *)UArray2_at(test_array, DIM1 - 1, DIM2 - 1)) = MARKER;
+        *((int *)UArray2_at(test_array, DIM1 - 1, DIM2 - 1)) = MARKER;
+
+        struct visit v = { true, 0, -1 };
+        UArray2_map_col_major(test_array, check_and_count, &v);
+        OK &= v.ok && v.count == DIM1 * DIM2;
+
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_row_major(test_array, check_and_count, &v);
+        OK &= v.ok && v.count == DIM1 * DIM2;
+
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_row_spans(test_array, check_row_span, &v);
+        OK &= v.ok && v.count == DIM2;
+
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_col_spans(test_array, check_col_span, &v);
+        OK &= v.ok && v.count == DIM1;
+
+        UArray2_free(&test_array);
+
+        /* each element exactly once, with more bands than threads */
+        int shapes[][3] = { { 37, 101, 3 }, { 5, 2, 4 }, { 1, 1, 8 } };
+        for (int k = 0; k < 3; k++) {
+                test_array = UArray2_new(shapes[k][0], shapes[k][1],
+                                         ELEMENT_SIZE);
+                UArray2_map_row_major(test_array, label, NULL);
+                UArray2_map_parallel(test_array, shapes[k][2], claim, NULL);
+
+                v = (struct visit){ true, 0, -1 };
+                UArray2_map_row_major(test_array, check_claimed, &v);
+                OK &= v.ok && v.count == shapes[k][0] * shapes[k][1];
+                UArray2_free(&test_array);
+        }
 
-        printf("Trying column major\n");
-        UArray2_map_col_major(test_array, check_and_print, &OK);
+        /* file-backed: map, fill, sync, reopen, change, reopen */
+        test_array = UArray2_map_file(MAP_PATH, DIM1, DIM2, ELEMENT_SIZE);
+        UArray2_map_row_major(test_array, label, NULL);
+        UArray2_sync(test_array);
+        UArray2_free(&test_array);
+
+        test_array = UArray2_open(MAP_PATH);
+        OK &= UArray2_width(test_array) == DIM1
+              && UArray2_height(test_array) == DIM2
+              && UArray2_size(test_array) == ELEMENT_SIZE;
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_row_major(test_array, check_labels, &v);
+        OK &= v.ok && v.count == DIM1 * DIM2;
+        *((int *)UArray2_at(test_array, DIM1 - 1, DIM2 - 1)) = MARKER;
+        UArray2_free(&test_array);
+
+        test_array = UArray2_open(MAP_PATH);
+        OK &= *((int *)UArray2_at(test_array, DIM1 - 1, DIM2 - 1)) == MARKER
+              && *((int *)UArray2_at(test_array, 0, 0)) == 0;
+        UArray2_free(&test_array);
+
+        /* a file-backed array without elements round-trips too */
+        test_array = UArray2_map_file(MAP_PATH, 0, DIM2, ELEMENT_SIZE);
+        UArray2_free(&test_array);
+        test_array = UArray2_open(MAP_PATH);
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_row_major(test_array, check_labels, &v);
+        OK &= UArray2_width(test_array) == 0
+              && UArray2_height(test_array) == DIM2 && v.count == 0;
+        UArray2_free(&test_array);
+
+        /* headers whose length check would overflow, or lie */
+        OK &= open_rejects(0x7fffffff, 0x7fffffff, 0x7fffffff);
+        OK &= open_rejects(0x7fffffff, 0x7fffffff, 1);
+        OK &= open_rejects(1, 1, 4);
+        OK &= open_rejects(1, 1, 0);
+        remove(MAP_PATH);
+
+        /* views share the window's elements, at any depth */
+        test_array = UArray2_new(DIM1, DIM2, ELEMENT_SIZE);
+        UArray2_map_row_major(test_array, label, NULL);
+
+        UArray2_T view = UArray2_view(test_array, 1, 2, 3, 4);
+        OK &= UArray2_width(view) == 3 && UArray2_height(view) == 4
+              && UArray2_size(view) == ELEMENT_SIZE
+              && UArray2_at(view, 0, 0) == UArray2_at(test_array, 1, 2)
+              && UArray2_at(view, 2, 3) == UArray2_at(test_array, 3, 5);
+        struct window w = { true, 0, 1, 2 };
+        UArray2_map_col_major(view, check_window, &w);
+        OK &= w.ok && w.count == 3 * 4;
+
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_row_spans(view, check_row_span, &v);
+        OK &= v.ok && v.count == 4;
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_col_spans(view, check_col_span, &v);
+        OK &= v.ok && v.count == 3;
+
+        UArray2_T inner = UArray2_view(view, 1, 1, 2, 3);
+        w = (struct window){ true, 0, 2, 3 };
+        UArray2_map_row_major(inner, check_window, &w);
+        OK &= w.ok && w.count == 2 * 3;
+        *((int *)UArray2_at(inner, 1, 2)) = MARKER;
+        OK &= *((int *)UArray2_at(test_array, 3, 5)) == MARKER;
+        UArray2_free(&inner);
+
+        UArray2_T empty = UArray2_view(view, 3, 4, 0, 0);
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_row_major(empty, check_and_count, &v);
+        OK &= UArray2_width(empty) == 0 && v.count == 0;
+        UArray2_free(&empty);
+
+        /* freeing a view leaves the array intact */
+        UArray2_free(&view);
+        OK &= view == NULL
+              && *((int *)UArray2_at(test_array, 0, 0)) == 0
+              && *((int *)UArray2_at(test_array, 3, 5)) == MARKER;
+        UArray2_free(&test_array);
+
+        /* fill and copy, on whole arrays and on views */
+        test_array = UArray2_new(DIM1, DIM2, ELEMENT_SIZE);
+        UArray2_fill(test_array, &MARKER);
+        struct value c = { true, 0, MARKER };
+        UArray2_map_row_major(test_array, check_value, &c);
+        OK &= c.ok && c.count == DIM1 * DIM2;
+
+        UArray2_map_row_major(test_array, label, NULL);
+        view = UArray2_view(test_array, 1, 2, 3, 4);
+        UArray2_T copy = UArray2_new(3, 4, ELEMENT_SIZE);
+        UArray2_copy(copy, view);
+        w = (struct window){ true, 0, 1, 2 };
+        UArray2_map_row_major(copy, check_window, &w);
+        OK &= w.ok && w.count == 3 * 4;
+
+        int zero = 0;
+        UArray2_fill(view, &zero);
+        c = (struct value){ true, 0, 0 };
+        UArray2_map_row_major(view, check_value, &c);
+        OK &= c.ok && c.count == 3 * 4
+              && *((int *)UArray2_at(test_array, 0, 2)) == 2
+              && *((int *)UArray2_at(test_array, 4, 2)) == 4002
+              && *((int *)UArray2_at(test_array, 1, 1)) == 1001
+              && *((int *)UArray2_at(test_array, 1, 6)) == 1006;
+
+        UArray2_copy(view, copy);
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_row_major(test_array, check_labels, &v);
+        OK &= v.ok && v.count == DIM1 * DIM2;
+        UArray2_free(&copy);
+        UArray2_free(&view);
+        UArray2_free(&test_array);
+
+        /* transpose: odd, non-square, thin, and past one tile */
+        int sizes[][2] = { { 5, 7 }, { 1, 9 }, { 9, 1 }, { 37, 19 },
+                           { 16, 33 } };
+        for (int k = 0; k < 5; k++) {
+                int width = sizes[k][0];
+                int height = sizes[k][1];
+
+                test_array = UArray2_new(width, height, ELEMENT_SIZE);
+                UArray2_map_row_major(test_array, label, NULL);
+                copy = UArray2_new(height, width, ELEMENT_SIZE);
+                UArray2_transpose(copy, test_array);
+
+                v = (struct visit){ true, 0, -1 };
+                UArray2_map_row_major(copy, check_transposed, &v);
+                OK &= v.ok && v.count == width * height;
+                UArray2_free(&copy);
+                UArray2_free(&test_array);
+        }
+
+        /* the transpose of a view is the transpose of its window */
+        test_array = UArray2_new(DIM1, DIM2, ELEMENT_SIZE);
+        UArray2_map_row_major(test_array, label, NULL);
+        view = UArray2_view(test_array, 0, 0, 3, 5);
+        copy = UArray2_new(5, 3, ELEMENT_SIZE);
+        UArray2_transpose(copy, view);
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_row_major(copy, check_transposed, &v);
+        OK &= v.ok && v.count == 3 * 5;
+        UArray2_free(&copy);
+        UArray2_free(&view);
+        UArray2_free(&test_array);
 
-        printf("Trying row major\n");
-        UArray2_map_row_major(test_array, check_and_print, &OK);
-        */
+        /* no spans at all for an array without elements */
+        test_array = UArray2_new(0, DIM2, ELEMENT_SIZE);
+        v = (struct visit){ true, 0, -1 };
+        UArray2_map_row_spans(test_array, check_row_span, &v);
+        UArray2_map_col_spans(test_array, check_col_span, &v);
+        OK &= v.count == 0;
         UArray2_free(&test_array);
-        
 
         printf("The array is %sOK!\n", (OK ? "" : "NOT "));
-        
 
+        return OK ? 0 : 1;
 }
@@ -0,0 +1,305 @@
+/**************************************************************
+ *
+ *                              uarray2b.c
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    <tvales01, >
+ *     Date:       <2025-09-25>
+ *
+ *     Implementation of a blocked 2-D unboxed array. The array is cut
+ *     into square blocks of blocksize × blocksize cells. Blocks are laid
+ *     out one after another (row-major order of blocks) in a single
+ *     contiguous allocation, and the cells of each block are stored
+ *     row-major inside the block. Edge blocks are allocated at full
+ *     size; cells past width/height are padding and never visited.
+ *
+ *     Dependencies:
+ *       assert.h (Hanson), mem.h (NEW/CALLOC/FREE).
+ *
+ *     Indices and order:
+ *       i = column, j = row.
+ *       Cell (i,j) is in block (i / blocksize, j / blocksize) at offset
+ *       (j % blocksize) * blocksize + (i % blocksize) within the block.
+ *
+ *     Representation invariant:
+ *       width >= 0; height >= 0; size > 0; blocksize >= 1.
+ *       bwidth  == ceil(width  / blocksize).
+ *       bheight == ceil(height / blocksize).
+ *       block_bytes == blocksize * blocksize * size.
+ *       blocks points to bwidth * bheight * block_bytes bytes, or is
+ *         NULL when the array has no cells.
+ *
+ *     Checked runtime errors (CREs):
+ *       UArray2b_new: width<0 || height<0 || size<=0 || blocksize<1.
+ *       UArray2b_at / maps: NULL handle, OOB indices, NULL apply.
+ *       UArray2b_free: NULL pointer or *ptr==NULL.
+ *
+ **************************************************************/
+
+#include <stddef.h>
+
+#include "uarray2b.h"
+#include "assert.h"
+#include "mem.h"
+
+/* Largest block, in bytes, chosen by UArray2b_new_64K_block */
+#define BLOCK_BYTES_64K (64 * 1024)
+
+struct UArray2b_T {
+        int width;
+        int height;
+        int size;
+        int blocksize;
+        int bwidth;             /* blocks per block-row */
+        int bheight;            /* block-rows */
+        long block_bytes;       /* bytes per block */
+        char *blocks;
+};
+
+/********** cell_at (static helper) ********
+ * Return the address of cell (col,row) without bounds checks.
+ ************************/
+static inline char *cell_at(UArray2b_T a, int col, int row)
+{
+        int bs = a->blocksize;
+        long block = (long)(row / bs) * a->bwidth + col / bs;
+        long cell  = (long)(row % bs) * bs + col % bs;
+
+        return a->blocks + block * a->block_bytes + cell * a->size;
+}
+
+/********** UArray2b_new ********
+ * Create a blocked 2-D array of col × row elements of `size` bytes.
+ *
+ * Parameters:
+ *      int col:       width  (#columns)  >= 0
+ *      int row:       height (#rows)     >= 0
+ *      int size:      element size in bytes (> 0)
+ *      int blocksize: cells per block side (>= 1)
+ *
+ * Returns:
+ *      UArray2b_T: new array with zero-filled element storage
+ *
+ * Effects:
+ *      Allocates the header and one block of storage for all blocks.
+ *
+ * CRE
+ *      CRE if col < 0 or row < 0 or size <= 0 or blocksize < 1
+ *      May CRE on allocation failure
+ ************************/
+UArray2b_T UArray2b_new(int col, int row, int size, int blocksize)
+{
+        assert(col >= 0 && row >= 0 && size > 0 && blocksize >= 1);
+
+        UArray2b_T uarray2b;
+        NEW(uarray2b);
+
+        uarray2b->width = col;
+        uarray2b->height = row;
+        uarray2b->size = size;
+        uarray2b->blocksize = blocksize;
+        uarray2b->bwidth = (col + blocksize - 1) / blocksize;
+        uarray2b->bheight = (row + blocksize - 1) / blocksize;
+        uarray2b->block_bytes = (long)blocksize * blocksize * size;
+        uarray2b->blocks = NULL;
+
+        /* Hanson ALLOC/CALLOC reject zero-byte requests */
+        if (col > 0 && row > 0) {
+                uarray2b->blocks = CALLOC((long)uarray2b->bwidth
+                                                * uarray2b->bheight,
+                                          uarray2b->block_bytes);
+        }
+
+        return uarray2b;
+}
+
+/********** UArray2b_new_64K_block ********
+ * Create a blocked array whose blocks are as large as possible while
+ * still fitting in 64KB (at least one cell per block).
+ *
+ * Parameters / CRE:
+ *      As UArray2b_new, without blocksize.
+ ************************/
+UArray2b_T UArray2b_new_64K_block(int col, int row, int size)
+{
+        assert(size > 0);
+
+        int blocksize = 1;
+        while ((long)(blocksize + 1) * (blocksize + 1) * size
+               <= BLOCK_BYTES_64K) {
+                blocksize++;
+        }
+
+        return UArray2b_new(col, row, size, blocksize);
+}
+
+/********** UArray2b_width / height / size / blocksize ********
+ * Return array dimensions, element size, and block side length.
+ *
+ * Parameters:
+ *      UArray2b_T a: non-NULL
+ *
+ * CRE
+ *      CRE if a == NULL
+ ************************/
+int UArray2b_width(UArray2b_T uarray2b)
+{
+        assert(uarray2b);
+        return uarray2b->width;
+}
+
+int UArray2b_height(UArray2b_T uarray2b)
+{
+        assert(uarray2b);
+        return uarray2b->height;
+}
+
+int UArray2b_size(UArray2b_T uarray2b)
+{
+        assert(uarray2b);
+        return uarray2b->size;
+}
+
+int UArray2b_blocksize(UArray2b_T uarray2b)
+{
+        assert(uarray2b);
+        return uarray2b->blocksize;
+}
+
+/********** UArray2b_at ********
+ * Return a pointer to the element at (col,row).
+ *
+ * Parameters:
+ *      UArray2b_T a: non-NULL array
+ *      int col:      0 <= col < width
+ *      int row:      0 <= row < height
+ *
+ * Returns:
+ *      void *: address of element storage, valid until array is freed
+ *
+ * CRE
+ *      CRE if a == NULL or indices out of bounds
+ ************************/
+void *UArray2b_at(UArray2b_T uarray2b, int col, int row)
+{
+        assert(uarray2b);
+        assert(col >= 0 && col < uarray2b->width);
+        assert(row >= 0 && row < uarray2b->height);
+
+        return cell_at(uarray2b, col, row);
+}
+
+/********** UArray2b_map_block_major ********
+ * Visit every element one block at a time and call apply for each.
+ *
+ * Parameters:
+ *      UArray2b_T a: array
+ *      void apply(int col, int row, UArray2b_T a2, void *elem, void *cl):
+ *                    client callback; `elem` points to element at (col,row)
+ *      void *cl:     closure passed through
+ *
+ * Order:
+ *      Blocks in row-major order of blocks; all cells of a block (in
+ *      row-major order within the block) before the next block. Storage
+ *      is visited sequentially.
+ *
+ * CRE
+ *      CRE if a == NULL or apply == NULL
+ ************************/
+void UArray2b_map_block_major(UArray2b_T uarray2b,
+                              void apply(int col, int row, UArray2b_T a,
+                                         void *p1, void *p2),
+                              void *cl)
+{
+        assert(uarray2b);
+        assert(apply);
+        int bs = uarray2b->blocksize;
+        int size = uarray2b->size;
+
+        for (int brow = 0; brow < uarray2b->bheight; brow++) {
+                for (int bcol = 0; bcol < uarray2b->bwidth; bcol++) {
+                        char *block = uarray2b->blocks
+                                + ((long)brow * uarray2b->bwidth + bcol)
+                                  * uarray2b->block_bytes;
+                        int row0 = brow * bs;
+                        int col0 = bcol * bs;
+                        int rows = uarray2b->height - row0 < bs
+                                 ? uarray2b->height - row0 : bs;
+                        int cols = uarray2b->width - col0 < bs
+                                 ? uarray2b->width - col0 : bs;
+
+                        for (int r = 0; r < rows; r++) {
+                                char *p = block + (long)r * bs * size;
+
+                                for (int c = 0; c < cols; c++, p += size) {
+                                        apply(col0 + c, row0 + r, uarray2b,
+                                              p, cl);
+                                }
+                        }
+                }
+        }
+}
+
+/********** UArray2b_map_row_major ********
+ * Visit every element in row-major order and call apply for each.
+ *
+ * Order:
+ *      Rows outermost (0..height-1), columns innermost (0..width-1).
+ *      A row touches one block per blocksize columns.
+ *
+ * CRE
+ *      CRE if a == NULL or apply == NULL
+ ************************/
+void UArray2b_map_row_major(UArray2b_T uarray2b,
+                            void apply(int col, int row, UArray2b_T a,
+                                       void *p1, void *p2),
+                            void *cl)
+{
+        assert(uarray2b);
+        assert(apply);
+
+        for (int row = 0; row < uarray2b->height; row++) {
+                for (int col = 0; col < uarray2b->width; col++) {
+                        apply(col, row, uarray2b, cell_at(uarray2b, col, row),
+                              cl);
+                }
+        }
+}
+
+/********** UArray2b_map_col_major ********
+ * Same as above but column-major: columns outermost, rows innermost.
+ ************************/
+void UArray2b_map_col_major(UArray2b_T uarray2b,
+                            void apply(int col, int row, UArray2b_T a,
+                                       void *p1, void *p2),
+                            void *cl)
+{
+        assert(uarray2b);
+        assert(apply);
+
+        for (int col = 0; col < uarray2b->width; col++) {
+                for (int row = 0; row < uarray2b->height; row++) {
+                        apply(col, row, uarray2b, cell_at(uarray2b, col, row),
+                              cl);
+                }
+        }
+}
+
+/********** UArray2b_free ********
+ * Free all storage and set *uarray2b to NULL.
+ *
+ * Parameters:
+ *      UArray2b_T *uarray2b: pointer to handle; *uarray2b must be non-NULL
+ *
+ * CRE
+ *      CRE if uarray2b == NULL or *uarray2b == NULL
+ ************************/
+void UArray2b_free(UArray2b_T *uarray2b)
+{
+        assert(uarray2b && *uarray2b);
+
+        if ((*uarray2b)->blocks != NULL) {
+                FREE((*uarray2b)->blocks);
+        }
+        FREE(*uarray2b);
+}
@@ -0,0 +1,66 @@
+/**************************************************************
+ *
+ *                       uarray2b.h
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    tvales01,
+ *     Date:       <2025-09-25>
+ *
+ *     Public interface for a blocked 2-D unboxed, polymorphic array.
+ *     Cells are grouped into square blocks of blocksize × blocksize
+ *     cells; every cell of a block is stored contiguously, so cells
+ *     that are near each other in either direction are near each other
+ *     in memory.
+ *
+ *     Indices and order:
+ *       i = column (0..width-1), j = row (0..height-1).
+ *       Block-major map: blocks in row-major order of blocks, and
+ *         within a block, cells in row-major order.
+ *       Row-major / col-major maps: same orders as UArray2.
+ *
+ *     Notes:
+ *       UArray2b_at returns a pointer to element storage valid until the
+ *       array is freed. Function contracts are documented in uarray2b.c.
+ *
+ **************************************************************/
+
+#ifndef UARRAY2B_INCLUDED
+#define UARRAY2B_INCLUDED
+
+#define T UArray2b_T
+typedef struct T *T;
+
+
+extern T UArray2b_new(int col, int row, int size, int blocksize);
+
+extern T UArray2b_new_64K_block(int col, int row, int size);
+
+extern int UArray2b_width(T uarray2b);
+
+extern int UArray2b_height(T uarray2b);
+
+extern int UArray2b_size(T uarray2b);
+
+extern int UArray2b_blocksize(T uarray2b);
+
+extern void *UArray2b_at(T uarray2b, int col, int row);
+
+extern void UArray2b_map_block_major(T uarray2b,
+                                     void apply(int col, int row, T uarray2b,
+                                                void *p1, void *cl),
+                                     void *cl);
+
+extern void UArray2b_map_row_major(T uarray2b,
+                                   void apply(int col, int row, T uarray2b,
+                                              void *p1, void *cl),
+                                   void *cl);
+
+extern void UArray2b_map_col_major(T uarray2b,
+                                   void apply(int col, int row, T uarray2b,
+                                              void *p1, void *cl),
+                                   void *cl);
+
+extern void UArray2b_free(T *uarray2b);
+
+#undef T
+#endif
@@ -0,0 +1,82 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include "uarray2b.h"
+
+const int DIM1 = 10;
+const int DIM2 = 7;
+const int ELEMENT_SIZE = sizeof(int);
+const int BLOCKSIZE = 3;
+const int MARKER = 99;
+
+struct visit {
+        bool ok;
+        int count;
+        int last_block;
+};
+
+void
+check_and_count(int i, int j, UArray2b_T a, void *p1, void *p2)
+{
+        struct visit *v = p2;
+
+        v->ok &= UArray2b_at(a, i, j) == p1;
+        if ( (i == (DIM1 - 1) ) && (j == (DIM2 - 1) ) ) {
+                /* we got the corner */
+                v->ok &= (*(int *)p1 == MARKER);
+        }
+        v->count++;
+}
+
+void
+check_block_order(int i, int j, UArray2b_T a, void *p1, void *p2)
+{
+        struct visit *v = p2;
+        int bw = (UArray2b_width(a) + BLOCKSIZE - 1) / BLOCKSIZE;
+        int block = (j / BLOCKSIZE) * bw + i / BLOCKSIZE;
+
+        /* blocks must never be revisited once left */
+        v->ok &= block >= v->last_block;
+        v->last_block = block;
+        check_and_count(i, j, a, p1, p2);
+}
+
+int main(int argc, char *argv[])
+{
+        (void)argc;
+        (void)argv;
+
+        UArray2b_T test_array;
+        bool OK = true;
+
+        test_array = UArray2b_new(DIM1, DIM2, ELEMENT_SIZE, BLOCKSIZE);
+
+        OK = (UArray2b_width(test_array) == DIM1) &&
+             (UArray2b_height(test_array) == DIM2) &&
+             (UArray2b_size(test_array) == ELEMENT_SIZE) &&
+             (UArray2b_blocksize(test_array) == BLOCKSIZE);
+
+        /* Note: we are only setting a value on the corner of the array */
+        *((int *)UArray2b_at(test_array, DIM1 - 1, DIM2 - 1)) = MARKER;
+
+        struct visit v = { true, 0, 0 };
+        UArray2b_map_block_major(test_array, check_block_order, &v);
+        OK &= v.ok && v.count == DIM1 * DIM2;
+
+        v = (struct visit){ true, 0, 0 };
+        UArray2b_map_row_major(test_array, check_and_count, &v);
+        OK &= v.ok && v.count == DIM1 * DIM2;
+
+        v = (struct visit){ true, 0, 0 };
+        UArray2b_map_col_major(test_array, check_and_count, &v);
+        OK &= v.ok && v.count == DIM1 * DIM2;
+
+        UArray2b_free(&test_array);
+
+        test_array = UArray2b_new_64K_block(DIM1, DIM2, ELEMENT_SIZE);
+        OK &= UArray2b_blocksize(test_array) == 128;
+        UArray2b_free(&test_array);
+
+        printf("The array is %sOK!\n", (OK ? "" : "NOT "));
+
+        return OK ? 0 : 1;
+}
@@ -0,0 +1,1225 @@
+/**************************************************************
+ *
+ *                       unblack.c
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    <tvales01, >
+ *     Date:       <2025-09-25>
+ *
+ *     Implementation of the in-memory black-edge removal library (see
+ *     unblack.h). A black edge pixel is any black pixel on the border,
+ *     or 4-connected to another black edge pixel. Algorithm: flood-fill
+ *     from all black border pixels over 4-neighbors, marking them in a
+ *     same-size Bit2 edges; then clear those pixels in img.
+ *
+ *     In-place mode (Unblack_options.inplace):
+ *       The engine clears each border-connected pixel in img as soon
+ *       as it reaches it, and a pixel counts as visited once it is
+ *       white. No edges bitmap is allocated and there is no final
+ *       clearing pass, so peak bitmap memory is halved. bfs, spans,
+ *       parallel and steal support it; words needs its reached set
+ *       apart from img, so it keeps using edges.
+ *
+ *     Fill engines (Unblack_options.fill):
+ *       bfs    per-pixel breadth-first search with a queue (default).
+ *       words  word-parallel fill: grows the reached set 64 pixels at
+ *              a time with shifts and masks, sweeping down and up the
+ *              rows until nothing changes. No per-pixel queue traffic.
+ *       spans  scanline fill: marks a maximal horizontal run of black
+ *              pixels at once and queues one span per run for each of
+ *              the rows above and below.
+ *       parallel  splits the rows into one band per thread
+ *              (Unblack_options.threads, default one per CPU). Each
+ *              thread labels the black runs of its band with
+ *              union-find; a serial pass merges labels across band
+ *              seams and finds the components that touch the border;
+ *              the threads then mark those components.
+ *       steal  parallel breadth-first search: every worker expands
+ *              pixels from its own work-stealing deque and steals from
+ *              the others when it runs dry (threads as above). Pixels
+ *              are claimed in edges with an atomic OR, so each is
+ *              expanded exactly once.
+ *
+ *     Dependencies:
+ *       bit2.h, bit2_fast.h, assert.h, mem.h, queue.h, deque.h,
+ *       pthread.h and unistd.h (parallel engines).
+ *
+ *     Checked runtime errors (CREs):
+ *       Unknown fill engine or negative thread count; NULL handle;
+ *       NULL rows; width or height <= 0. All are checked on the
+ *       calling thread before any worker thread starts. Code that runs
+ *       on a worker thread must not raise (see unblack.h). The
+ *       parallel engine allocates there with malloc and reports a
+ *       failure back to the calling thread.
+ *
+ **************************************************************/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "unblack.h"
+#include "assert.h"
+#include "bit2_fast.h"
+#include "deque.h"
+#include "queue.h"
+#include "mem.h"
+
+#define T Unblack_T
+
+/*
+ * A fill engine marks, in edges (all 0 on entry), every black pixel of
+ * img that is 4-connected to a black border pixel. It must not change
+ * img. It may keep buffers in unblack for the next image. An engine
+ * that supports in-place mode is instead called with edges == NULL
+ * and clears those pixels in img.
+ */
+typedef void Fill_fn(Bit2_T img, Bit2_T edges, T unblack);
+
+/*
+ * The engine and the buffers kept from one image to the next: the
+ * edges bitmap (reshaped to each image, see Bit2_reshape) and the
+ * queues of the queue-based engines. Each buffer is NULL until first
+ * needed.
+ */
+struct T {
+        Fill_fn *fill;
+        int threads;            /* 0 = one per online CPU */
+        int inplace;            /* call fill with edges == NULL */
+        Bit2_T edges;           /* NULL in in-place mode */
+        RingQ_T pixels;         /* fill_bfs */
+        RingQ_T spans;          /* fill_spans */
+};
+
+static Fill_fn fill_bfs;
+static Fill_fn fill_words;
+static Fill_fn fill_spans;
+static Fill_fn fill_parallel;
+static Fill_fn fill_steal;
+static void enq_if_black(Bit2_T img, int col, int row, RingQ_T bitQ,
+                         Bit2_T edges);
+static void check_black_neighbors(Bit2_T img, RingQ_T bitQ, Bit2_T edges);
+static int grow_row(uint64_t *reached, const uint64_t *neighbor,
+                    const uint64_t *black, int wpr);
+static int spread_row(uint64_t *reached, const uint64_t *black, int wpr);
+static void enq_span(RingQ_T spanQ, int row, int left, int right);
+
+/* Closure of the steal engine's tasks */
+typedef struct Steal_cl {
+        Bit2_T img;
+        Bit2_T edges;
+        int width;
+        int height;
+} Steal_cl;
+
+/*
+ * Fill engines selectable by name; the first is the default. inplace
+ * is nonzero for engines that accept edges == NULL.
+ */
+static const struct {
+        const char *name;
+        Fill_fn *fill;
+        int inplace;
+} engines[] = {
+        { "bfs",      fill_bfs,      1 },
+        { "words",    fill_words,    0 },
+        { "spans",    fill_spans,    1 },
+        { "parallel", fill_parallel, 1 },
+        { "steal",    fill_steal,    1 },
+};
+
+/* Struct holds the index of a bit in bit2; queued by value */
+typedef struct Index {
+        int col;
+        int row;
+} Index;
+
+/* Columns left..right (inclusive) of one row, still to be scanned */
+typedef struct Span {
+        int row;
+        int left;
+        int right;
+} Span;
+
+/* Indices the BFS engine takes off its queue at a time */
+#define BFS_BATCH 256
+
+/* A maximal run of black pixels: columns left..right of one row */
+typedef struct Run {
+        int row;
+        int left;
+        int right;
+} Run;
+
+/*
+ * One band of consecutive rows, handled by one thread of the parallel
+ * engine. runs[row_start[k] .. row_start[k + 1] - 1] are the runs of
+ * row first_row + k, left to right. parent is band-local union-find
+ * while labelling; for marking it is the global, flattened label array
+ * and runs[i] has global index offset + i.
+ */
+typedef struct Band {
+        Bit2_T img;
+        Bit2_T edges;
+        int first_row;
+        int rows;
+        Run *runs;
+        int nruns;
+        int capacity;
+        int *row_start;
+        int *parent;
+        int failed;             /* label_band ran out of memory */
+        int offset;
+        const char *border;     /* per global root: touches the border */
+} Band;
+
+static int find_engine(const char *name);
+static int thread_count(T unblack);
+static Sched_task steal_pixel;
+static int claim_if_black(Bit2_T img, Bit2_T edges, int col, int row);
+static int next_bit(const uint64_t *words, int wpr, int col, uint64_t flip);
+static int find_root(int *parent, int x);
+static void union_roots(int *parent, int a, int b);
+static void union_adjacent(int *parent, const Run *above, int n_above,
+                           int above_base, const Run *below,
+                           int n_below, int below_base);
+static void *label_band(void *arg);
+static void *mark_band(void *arg);
+static void run_bands(Band *bands, int nbands,
+                      void *work(void *band));
+
+/********** Unblack_new ********
+ * Create a reusable black-edge remover.
+ *
+ * Parameters:
+ *      const Unblack_options *options: engine, thread count and
+ *                                      in-place mode, or NULL for all
+ *                                      defaults
+ *
+ * Returns:
+ *      Unblack_T: new handle with no buffers yet; free with
+ *                 Unblack_free
+ *
+ * Notes:
+ *      options->inplace is ignored for an engine that does not support
+ *      it (see top of file).
+ *
+ * CRE
+ *      CRE if options->fill names no engine (see top of file) or
+ *      options->threads < 0
+ *      May CRE on allocation failure
+ ************************/
+T Unblack_new(const Unblack_options *options)
+{
+        int e = 0;
+        int threads = 0;
+        int inplace = 0;
+
+        if (options != NULL) {
+                e = find_engine(options->fill);
+                assert(e >= 0);
+                assert(options->threads >= 0);
+                threads = options->threads;
+                inplace = options->inplace && engines[e].inplace;
+        }
+
+        T unblack;
+        NEW(unblack);
+        unblack->fill = engines[e].fill;
+        unblack->threads = threads;
+        unblack->inplace = inplace;
+        unblack->edges = NULL;
+        unblack->pixels = NULL;
+        unblack->spans = NULL;
+
+        return unblack;
+}
+
+/********** Unblack_has_engine ********
+ * Return whether name is a fill engine Unblack_new accepts, so a
+ * caller can reject a bad name before it reads any input.
+ *
+ * Parameters:
+ *      const char *name: engine name, or NULL for the default
+ *
+ * Returns:
+ *      int: 1 if name is NULL or names an engine (see top of file),
+ *           else 0
+ ************************/
+int Unblack_has_engine(const char *name)
+{
+        return find_engine(name) >= 0;
+}
+
+/********** Unblack_free ********
+ * Free the handle and every buffer it holds; set *unblack to NULL.
+ *
+ * CRE
+ *      CRE if unblack == NULL or *unblack == NULL
+ ************************/
+void Unblack_free(T *unblack)
+{
+        assert(unblack != NULL && *unblack != NULL);
+
+        if ((*unblack)->edges != NULL) {
+                Bit2_free(&(*unblack)->edges);
+        }
+        if ((*unblack)->pixels != NULL) {
+                RingQ_free(&(*unblack)->pixels);
+        }
+        if ((*unblack)->spans != NULL) {
+                RingQ_free(&(*unblack)->spans);
+        }
+        FREE(*unblack);
+}
+
+/********** Unblack_bit2 ********
+ * Remove the black edge pixels of img in place.
+ *
+ * Parameters:
+ *      Unblack_T unblack: engine and buffers to use
+ *      Bit2_T img:        bitmap, 1 = black; cleaned on return
+ *
+ * Effects:
+ *      Reshapes the kept edges bitmap (allocating it the first time)
+ *      to an all-0 grid the size of img; the engine marks edge-connected
+ *      black pixels in it; then clears every marked pixel in img with
+ *      one word-wise pass (img &= ~edges). In in-place mode the engine
+ *      clears the pixels itself and edges is never allocated.
+ *
+ * CRE
+ *      CRE if unblack or img is NULL, or img is empty
+ ************************/
+void Unblack_bit2(T unblack, Bit2_T img)
+{
+        assert(unblack != NULL && img != NULL);
+        assert(Bit2_width(img) > 0 && Bit2_height(img) > 0);
+
+        if (unblack->inplace) {
+                unblack->fill(img, NULL, unblack);
+                return;
+        }
+
+        /*
+         * Bit2 is a parallel array to original image that will mark the bits
+         * that need to be unblacked
+         */
+        if (unblack->edges == NULL) {
+                unblack->edges = Bit2_new(Bit2_width(img), Bit2_height(img));
+        }
+        else {
+                Bit2_reshape(unblack->edges, Bit2_width(img),
+                             Bit2_height(img));
+        }
+
+        unblack->fill(img, unblack->edges, unblack);
+        Bit2_andnot(img, unblack->edges);
+}
+
+/********** Unblack_rows ********
+ * Remove the black edge pixels of an image held as packed rows.
+ *
+ * Parameters:
+ *      Unblack_T unblack:         engine and buffers to use
+ *      const unsigned char *rows: height rows of (width + 7) / 8 bytes,
+ *                                 laid out as raw PBM (P4) pixel data
+ *                                 (MSB = leftmost pixel, 1 = black)
+ *      int width, int height:     image size, both > 0
+ *
+ * Returns:
+ *      Bit2_T: new cleaned bitmap; the caller frees it. rows is not
+ *              changed.
+ *
+ * CRE
+ *      CRE if unblack or rows is NULL, or width or height <= 0
+ ************************/
+Bit2_T Unblack_rows(T unblack, const unsigned char *rows, int width,
+                    int height)
+{
+        assert(unblack != NULL && rows != NULL);
+        assert(width > 0 && height > 0);
+
+        Bit2_T img = Bit2_new(width, height);
+        Bit2_load_p4_rows(img, rows);
+        Unblack_bit2(unblack, img);
+
+        return img;
+}
+
+/********** find_engine ********
+ * Return the index in engines of the engine called name (0, the
+ * default, for NULL), or -1 if there is none.
+ ************************/
+static int find_engine(const char *name)
+{
+        int n = sizeof(engines) / sizeof(engines[0]);
+
+        if (name == NULL) {
+                return 0;
+        }
+        for (int e = 0; e < n; e++) {
+                if (strcmp(engines[e].name, name) == 0) {
+                        return e;
+                }
+        }
+        return -1;
+}
+
+/********** thread_count ********
+ * Return the threads a parallel engine should use: the configured
+ * count if nonzero, else the number of online CPUs (at least 1).
+ ************************/
+static int thread_count(T unblack)
+{
+        if (unblack->threads > 0) {
+                return unblack->threads;
+        }
+
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        return cpus > 0 && cpus <= INT_MAX ? (int)cpus : 1;
+}
+
+/********** fill_bfs ********
+ * Fill engine: breadth-first search from every black border pixel.
+ *
+ * Parameters:
+ *      Bit2_T img, Bit2_T edges, Unblack_T unblack: as Fill_fn
+ *
+ * Notes:
+ *      Indices are copied into a ring-buffer queue, so nothing is
+ *      allocated per pixel. The queue is kept in unblack->pixels (empty
+ *      again on return) and reused by the next image.
+ ************************/
+static void fill_bfs(Bit2_T img, Bit2_T edges, T unblack)
+{
+        /* Queue to check each black edge pixel */
+        if (unblack->pixels == NULL) {
+                unblack->pixels = RingQ_new(sizeof(Index),
+                                       2 * (Bit2_width(img)
+                                            + Bit2_height(img)));
+        }
+        RingQ_T bitQ = unblack->pixels;
+
+        /* The two for loops check for black pixels at the very edge */
+        for (int col = 0; col < Bit2_width(img); col++)  {
+                enq_if_black(img, col, 0, bitQ, edges);
+                enq_if_black(img, col, Bit2_height(img) - 1, bitQ, edges);
+        }
+
+        for (int row = 0; row < Bit2_height(img); row++) {
+                enq_if_black(img, 0, row, bitQ, edges);
+                enq_if_black(img, Bit2_width(img) - 1, row, bitQ, edges);
+        }
+
+        check_black_neighbors(img, bitQ, edges);
+}
+
+/********** check_black_neighbors ********
+ * BFS pop from queue and examine 4-neighbors, enqueueing newly discovered
+ * edge-connected black pixels.
+ *
+ * Parameters:
+ *      Bit2_T img, RingQ_T bitQ, Bit2_T edges
+ *
+ * Returns:
+ *      None
+ *
+ * Notes:
+ *      Dequeues up to BFS_BATCH indices at a time into a local array.
+ ************************/
+static void check_black_neighbors(Bit2_T img, RingQ_T bitQ, Bit2_T edges)
+{
+        int width = Bit2_width(img);
+        int height = Bit2_height(img);
+        Index batch[BFS_BATCH];
+        int n;
+
+        /* Breadth-first traversal to check all neighbors*/
+        while ((n = RingQ_deq_n(bitQ, batch, BFS_BATCH)) > 0) {
+                for (int k = 0; k < n; k++) {
+                        int col = batch[k].col;
+                        int row = batch[k].row;
+
+                        /* Check if the 4 neighbors are black */
+                        if (col - 1 >= 0) {
+                                enq_if_black(img, col - 1, row, bitQ, edges);
+                        }
+                        if (col + 1 < width) {
+                                enq_if_black(img, col + 1, row, bitQ, edges);
+                        }
+                        if (row - 1 >= 0) {
+                                enq_if_black(img, col, row - 1, bitQ, edges);
+                        }
+                        if (row + 1 < height) {
+                                enq_if_black(img, col, row + 1, bitQ, edges);
+                        }
+                }
+        }
+}
+
+/********** enq_if_black ********
+ * If (col,row) is black in img and unmarked in edges, mark and enqueue.
+ * With edges == NULL (in-place mode), if it is black, clear it in img
+ * and enqueue.
+ *
+ * Parameters:
+ *      Bit2_T img, int col, int row, RingQ_T bitQ, Bit2_T edges
+ *
+ * Returns:
+ *      None
+ *
+ * CRE
+ *      CRE if indices are out of bounds (unless built with
+ *      UNCHECKED_ACCESS; see bit2_fast.h)
+ ************************/
+static void enq_if_black(Bit2_T img, int col, int row, RingQ_T bitQ,
+                         Bit2_T edges)
+{
+        if (edges == NULL) {
+                /* a cleared pixel is a visited one */
+                if (Bit2_put_fast(img, col, row, 0) == 1) {
+                        Index i = { col, row };
+                        RingQ_enq(bitQ, &i);
+                }
+                return;
+        }
+
+        /* If the pixel at index is black and has not been traversed yet */
+        if (Bit2_get_fast(img, col, row) == 1
+            && Bit2_get_fast(edges, col, row) == 0) {
+                Index i = { col, row };
+
+                /* Enqueue the pixel to the queue and mark it in the bit array*/
+                RingQ_enq(bitQ, &i);
+                Bit2_put_fast(edges, col, row, 1);
+        }
+}
+
+/********** fill_spans ********
+ * Fill engine: scanline flood fill, one queue entry per black run.
+ *
+ * Parameters:
+ *      Bit2_T img, Bit2_T edges, Unblack_T unblack: as Fill_fn
+ *
+ * Effects:
+ *      Queues the border as spans. For each span dequeued, finds every
+ *      unmarked black pixel in it, extends it left and right to the
+ *      whole black run, marks the run in edges (in in-place mode,
+ *      clears it in img), and queues the run's columns for the rows
+ *      above and below. A run is marked before its neighbours are
+ *      queued, so no run is filled twice.
+ *
+ * Notes:
+ *      Spans are copied into a ring-buffer queue, so nothing is
+ *      allocated per span. The queue is kept in unblack->spans for the
+ *      next image.
+ ************************/
+static void fill_spans(Bit2_T img, Bit2_T edges, T unblack)
+{
+        int width = Bit2_width(img);
+        int height = Bit2_height(img);
+
+        if (unblack->spans == NULL) {
+                unblack->spans = RingQ_new(sizeof(Span), 2 * height);
+        }
+        RingQ_T spanQ = unblack->spans;
+
+        enq_span(spanQ, 0, 0, width - 1);
+        enq_span(spanQ, height - 1, 0, width - 1);
+        for (int row = 1; row < height - 1; row++) {
+                enq_span(spanQ, row, 0, 0);
+                enq_span(spanQ, row, width - 1, width - 1);
+        }
+
+        while (!RingQ_empty(spanQ)) {
+                Span span;
+                RingQ_deq(spanQ, &span);
+                int row = span.row;
+
+                for (int col = span.left; col <= span.right; col++) {
+                        if (Bit2_get_fast(img, col, row) == 0
+                            || (edges != NULL
+                                && Bit2_get_fast(edges, col, row) == 1)) {
+                                continue;
+                        }
+
+                        /* grow to the whole black run around col */
+                        int left = col;
+                        int right = col;
+                        while (left > 0
+                               && Bit2_get_fast(img, left - 1, row) == 1) {
+                                left--;
+                        }
+                        while (right < width - 1
+                               && Bit2_get_fast(img, right + 1, row) == 1) {
+                                right++;
+                        }
+
+                        if (edges == NULL) {
+                                Bit2_clear_run_fast(Bit2_row_fast(img, row),
+                                                    left, right);
+                        }
+                        else {
+                                Bit2_set_run_fast(Bit2_row_fast(edges, row),
+                                                  left, right);
+                        }
+                        if (row > 0) {
+                                enq_span(spanQ, row - 1, left, right);
+                        }
+                        if (row < height - 1) {
+                                enq_span(spanQ, row + 1, left, right);
+                        }
+                        col = right;
+                }
+        }
+}
+
+/********** enq_span ********
+ * Queue columns left..right of row for fill_spans to scan.
+ ************************/
+static void enq_span(RingQ_T spanQ, int row, int left, int right)
+{
+        Span span = { row, left, right };
+
+        RingQ_enq(spanQ, &span);
+}
+
+/********** fill_words ********
+ * Fill engine: word-parallel flood fill over whole rows of packed bits.
+ *
+ * Parameters:
+ *      Bit2_T img, Bit2_T edges, Unblack_T unblack: as Fill_fn
+ *
+ * Effects:
+ *      Seeds edges with the black pixels of the border. Then sweeps down
+ *      the rows, OR-ing each row's reached set with (row above & black)
+ *      and spreading it sideways along black runs, and sweeps back up
+ *      the same way from the row below. Sweeps repeat until a full down
+ *      and up pass changes nothing. Every step works on 64 pixels at a
+ *      time; no pixel is ever queued.
+ *
+ * Notes:
+ *      Each pass pair reaches any pixel whose path from the border
+ *      turns from downward to upward (or back) one more time, so the
+ *      number of passes is small except on maze-like images.
+ ************************/
+static void fill_words(Bit2_T img, Bit2_T edges, T unblack)
+{
+        (void)unblack;
+        int width = Bit2_width(img);
+        int height = Bit2_height(img);
+        int wpr = (width + BIT2_WORD_BITS - 1) / BIT2_WORD_BITS;
+        int last = (width - 1) / BIT2_WORD_BITS;
+        uint64_t last_bit = (uint64_t)1 << ((width - 1) % BIT2_WORD_BITS);
+
+        /* Seed with black border pixels: all of rows 0 and height - 1,
+         * the first and last column of every other row */
+        for (int row = 0; row < height; row++) {
+                const uint64_t *black = Bit2_row_fast(img, row);
+                uint64_t *reached = Bit2_row_fast(edges, row);
+
+                if (row == 0 || row == height - 1) {
+                        for (int k = 0; k < wpr; k++) {
+                                reached[k] = black[k];
+                        }
+                }
+                else {
+                        reached[0] |= black[0] & 1;
+                        reached[last] |= black[last] & last_bit;
+                }
+        }
+
+        int changed;
+        do {
+                changed = spread_row(Bit2_row_fast(edges, 0),
+                                     Bit2_row_fast(img, 0), wpr);
+
+                for (int row = 1; row < height; row++) {
+                        changed |= grow_row(Bit2_row_fast(edges, row),
+                                            Bit2_row_fast(edges, row - 1),
+                                            Bit2_row_fast(img, row), wpr);
+                }
+                for (int row = height - 2; row >= 0; row--) {
+                        changed |= grow_row(Bit2_row_fast(edges, row),
+                                            Bit2_row_fast(edges, row + 1),
+                                            Bit2_row_fast(img, row), wpr);
+                }
+        } while (changed);
+}
+
+/********** grow_row (static helper) ********
+ * Add to a row's reached set the black pixels directly below or above
+ * a reached pixel of the neighbouring row, then spread along runs.
+ *
+ * Parameters:
+ *      uint64_t *reached:        the row's reached bits
+ *      const uint64_t *neighbor: reached bits of the row above or below
+ *      const uint64_t *black:    the row's black bits
+ *      int wpr:                  words per row
+ *
+ * Returns:
+ *      1 if any bit of reached changed, else 0
+ ************************/
+static int grow_row(uint64_t *reached, const uint64_t *neighbor,
+                    const uint64_t *black, int wpr)
+{
+        uint64_t changed = 0;
+
+        for (int k = 0; k < wpr; k++) {
+                uint64_t grown = reached[k] | (neighbor[k] & black[k]);
+
+                changed |= grown ^ reached[k];
+                reached[k] = grown;
+        }
+        return spread_row(reached, black, wpr) || changed != 0;
+}
+
+/********** fill_up / fill_down (static helpers) ********
+ * Spread the bits of gen along runs of 1s in pro within one word,
+ * toward higher bit positions (fill_up) or lower ones (fill_down).
+ * Kogge-Stone style: six shift/and/or steps cover any run length.
+ * gen must be a subset of pro.
+ ************************/
+static inline uint64_t fill_up(uint64_t gen, uint64_t pro)
+{
+        gen |= pro & (gen << 1);
+        pro &= pro << 1;
+        gen |= pro & (gen << 2);
+        pro &= pro << 2;
+        gen |= pro & (gen << 4);
+        pro &= pro << 4;
+        gen |= pro & (gen << 8);
+        pro &= pro << 8;
+        gen |= pro & (gen << 16);
+        pro &= pro << 16;
+        gen |= pro & (gen << 32);
+        return gen;
+}
+
+static inline uint64_t fill_down(uint64_t gen, uint64_t pro)
+{
+        gen |= pro & (gen >> 1);
+        pro &= pro >> 1;
+        gen |= pro & (gen >> 2);
+        pro &= pro >> 2;
+        gen |= pro & (gen >> 4);
+        pro &= pro >> 4;
+        gen |= pro & (gen >> 8);
+        pro &= pro >> 8;
+        gen |= pro & (gen >> 16);
+        pro &= pro >> 16;
+        gen |= pro & (gen >> 32);
+        return gen;
+}
+
+/********** spread_row (static helper) ********
+ * Grow a row's reached set to cover every black run it touches.
+ *
+ * Parameters:
+ *      uint64_t *reached:     the row's reached bits (subset of black)
+ *      const uint64_t *black: the row's black bits
+ *      int wpr:               words per row
+ *
+ * Returns:
+ *      1 if any bit of reached changed, else 0
+ *
+ * Effects:
+ *      One pass toward higher columns (carrying out of bit 63 into bit 0
+ *      of the next word) and one toward lower columns (carrying out of
+ *      bit 0 into bit 63 of the previous word). After the upward pass
+ *      every touched run is reached from its lowest seed to its top
+ *      end, so the downward pass completes it.
+ ************************/
+static int spread_row(uint64_t *reached, const uint64_t *black, int wpr)
+{
+        uint64_t changed = 0;
+        uint64_t carry = 0;
+
+        for (int k = 0; k < wpr; k++) {
+                uint64_t gen = reached[k] | (carry & black[k]);
+                uint64_t spread = fill_up(gen, black[k]);
+
+                changed |= spread ^ reached[k];
+                reached[k] = spread;
+                carry = spread >> (BIT2_WORD_BITS - 1);
+        }
+
+        carry = 0;
+        for (int k = wpr - 1; k >= 0; k--) {
+                uint64_t top = carry << (BIT2_WORD_BITS - 1);
+                uint64_t gen = reached[k] | (top & black[k]);
+                uint64_t spread = fill_down(gen, black[k]);
+
+                changed |= spread ^ reached[k];
+                reached[k] = spread;
+                carry = spread & 1;
+        }
+
+        return changed != 0;
+}
+
+/********** fill_parallel ********
+ * Fill engine: band-parallel connected-component labelling.
+ *
+ * Parameters:
+ *      Bit2_T img, Bit2_T edges, Unblack_T unblack: as Fill_fn
+ *
+ * Effects:
+ *      1. Splits the rows into one band per thread (see
+ *         thread_count). Each thread lists the black runs of its band
+ *         and unions vertically overlapping runs (label_band).
+ *      2. Serially: concatenates the band labels into one union-find,
+ *         unions runs across each band seam, flattens every label to
+ *         its root, and flags the roots of runs that touch the border.
+ *      3. Each thread marks in edges the runs of its band whose root
+ *         is flagged (mark_band).
+ *      The serial step is linear in the number of runs, not pixels.
+ *      Raises Mem_Failed, on this thread, if a band ran out of memory.
+ *
+ * Notes:
+ *      Union always links the larger root under the smaller, so every
+ *      label is <= its own index and one ascending pass flattens them.
+ ************************/
+static void fill_parallel(Bit2_T img, Bit2_T edges, T unblack)
+{
+        int width = Bit2_width(img);
+        int height = Bit2_height(img);
+        int nbands = thread_count(unblack);
+
+        if (nbands > height) {
+                nbands = height;
+        }
+
+        Band *bands = CALLOC(nbands, sizeof(*bands));
+        for (int b = 0; b < nbands; b++) {
+                bands[b].img = img;
+                bands[b].edges = edges;
+                bands[b].first_row = (int)((long)height * b / nbands);
+                bands[b].rows = (int)((long)height * (b + 1) / nbands)
+                              - bands[b].first_row;
+                bands[b].row_start = ALLOC((bands[b].rows + 1L)
+                                           * sizeof(int));
+        }
+
+        run_bands(bands, nbands, label_band);
+
+        int failed = 0;
+        for (int b = 0; b < nbands; b++) {
+                failed |= bands[b].failed;
+        }
+        if (failed) {
+                for (int b = 0; b < nbands; b++) {
+                        free(bands[b].runs);
+                        free(bands[b].parent);
+                        FREE(bands[b].row_start);
+                }
+                FREE(bands);
+                RAISE(Mem_Failed);
+        }
+
+        /* One global union-find over every band's runs */
+        int total = 0;
+        for (int b = 0; b < nbands; b++) {
+                bands[b].offset = total;
+                total += bands[b].nruns;
+        }
+
+        int *parent = NULL;
+        char *border = NULL;
+        if (total > 0) {
+                parent = ALLOC((long)total * sizeof(*parent));
+                border = CALLOC(total, sizeof(*border));
+        }
+
+        for (int b = 0; b < nbands; b++) {
+                for (int i = 0; i < bands[b].nruns; i++) {
+                        parent[bands[b].offset + i] = bands[b].offset
+                                                    + bands[b].parent[i];
+                }
+        }
+
+        /* Merge across seams: last row of band b - 1, first row of b */
+        for (int b = 1; b < nbands; b++) {
+                Band *up = &bands[b - 1];
+                Band *down = &bands[b];
+                int up_first = up->row_start[up->rows - 1];
+
+                union_adjacent(parent,
+                               up->runs + up_first, up->nruns - up_first,
+                               up->offset + up_first,
+                               down->runs, down->row_start[1],
+                               down->offset);
+        }
+
+        for (int i = 0; i < total; i++) {
+                parent[i] = parent[parent[i]];
+        }
+
+        for (int b = 0; b < nbands; b++) {
+                for (int i = 0; i < bands[b].nruns; i++) {
+                        Run *run = &bands[b].runs[i];
+
+                        if (run->row == 0 || run->row == height - 1
+                            || run->left == 0 || run->right == width - 1) {
+                                border[parent[bands[b].offset + i]] = 1;
+                        }
+                }
+        }
+
+        for (int b = 0; b < nbands; b++) {
+                free(bands[b].parent);
+                bands[b].parent = parent;
+                bands[b].border = border;
+        }
+
+        run_bands(bands, nbands, mark_band);
+
+        for (int b = 0; b < nbands; b++) {
+                free(bands[b].runs);
+                FREE(bands[b].row_start);
+        }
+        if (parent != NULL) {
+                FREE(parent);
+                FREE(border);
+        }
+        FREE(bands);
+}
+
+/********** fill_steal ********
+ * Fill engine: breadth-first search spread over worker threads with
+ * work stealing (see deque.h).
+ *
+ * Parameters:
+ *      Bit2_T img, Bit2_T edges, Unblack_T unblack: as Fill_fn
+ *
+ * Effects:
+ *      Claims every black border pixel and deals them out as seeds;
+ *      Sched_run then expands them with steal_pixel on thread_count()
+ *      workers. Pixels travel as row * width + col, so nothing is
+ *      allocated per pixel.
+ ************************/
+static void fill_steal(Bit2_T img, Bit2_T edges, T unblack)
+{
+        int width = Bit2_width(img);
+        int height = Bit2_height(img);
+        Steal_cl cl = { img, edges, width, height };
+        long *seeds = ALLOC((2L * width + 2L * height) * sizeof(*seeds));
+        long nseeds = 0;
+
+        for (int col = 0; col < width; col++) {
+                if (claim_if_black(img, edges, col, 0)) {
+                        seeds[nseeds++] = col;
+                }
+                if (claim_if_black(img, edges, col, height - 1)) {
+                        seeds[nseeds++] = (long)(height - 1) * width + col;
+                }
+        }
+        for (int row = 0; row < height; row++) {
+                if (claim_if_black(img, edges, 0, row)) {
+                        seeds[nseeds++] = (long)row * width;
+                }
+                if (claim_if_black(img, edges, width - 1, row)) {
+                        seeds[nseeds++] = (long)row * width + width - 1;
+                }
+        }
+
+        Sched_run(thread_count(unblack), seeds, nseeds, steal_pixel, &cl);
+
+        FREE(seeds);
+}
+
+/********** steal_pixel (Sched_task) ********
+ * Expand one claimed pixel: claim each black 4-neighbour not yet in
+ * edges and spawn it on this worker's deque.
+ *
+ * Parameters:
+ *      Sched_T sched: the running worker
+ *      long item:     row * width + col of the pixel
+ *      void *cl:      Steal_cl *
+ ************************/
+static void steal_pixel(Sched_T sched, long item, void *cl)
+{
+        Steal_cl *s = cl;
+        int col = (int)(item % s->width);
+        int row = (int)(item / s->width);
+
+        if (col - 1 >= 0 && claim_if_black(s->img, s->edges, col - 1, row)) {
+                Sched_spawn(sched, item - 1);
+        }
+        if (col + 1 < s->width
+            && claim_if_black(s->img, s->edges, col + 1, row)) {
+                Sched_spawn(sched, item + 1);
+        }
+        if (row - 1 >= 0 && claim_if_black(s->img, s->edges, col, row - 1)) {
+                Sched_spawn(sched, item - s->width);
+        }
+        if (row + 1 < s->height
+            && claim_if_black(s->img, s->edges, col, row + 1)) {
+                Sched_spawn(sched, item + s->width);
+        }
+}
+
+/********** claim_if_black ********
+ * If (col,row) is black in img, set it in edges with one atomic OR and
+ * return whether this call was the one that set it. Any number of
+ * threads may claim pixels of the same edges at once. With edges ==
+ * NULL (in-place mode) the pixel is claimed by clearing it in img with
+ * one atomic AND instead.
+ ************************/
+static int claim_if_black(Bit2_T img, Bit2_T edges, int col, int row)
+{
+        uint64_t mask = (uint64_t)1 << (col % BIT2_WORD_BITS);
+
+        if (edges == NULL) {
+                /* in place: img is shared, so even the test is atomic */
+                uint64_t *word = Bit2_row_fast(img, row)
+                               + col / BIT2_WORD_BITS;
+
+                if ((__atomic_load_n(word, __ATOMIC_RELAXED) & mask) == 0) {
+                        return 0;
+                }
+                return (__atomic_fetch_and(word, ~mask, __ATOMIC_RELAXED)
+                        & mask) != 0;
+        }
+
+        if (Bit2_get_fast(img, col, row) == 0) {
+                return 0;
+        }
+
+        uint64_t *word = Bit2_row_fast(edges, row) + col / BIT2_WORD_BITS;
+
+        /* a plain load first keeps claimed pixels off the bus lock */
+        if (__atomic_load_n(word, __ATOMIC_RELAXED) & mask) {
+                return 0;
+        }
+        return (__atomic_fetch_or(word, mask, __ATOMIC_RELAXED) & mask) == 0;
+}
+
+/********** label_band (thread body) ********
+ * List the black runs of a band's rows and union every pair of runs in
+ * adjacent rows of the band that overlap (share a column).
+ *
+ * Parameters:
+ *      void *arg: Band * with img, first_row, rows and row_start set
+ *
+ * Effects:
+ *      Sets runs, nruns, row_start and parent (band-local indices).
+ *      runs and parent come from malloc, not ALLOC: a Mem_Failed
+ *      raised on a worker thread would unwind through Except_stack,
+ *      which belongs to the calling thread. On failure it sets failed
+ *      and returns; fill_parallel raises Mem_Failed after the join.
+ ************************/
+static void *label_band(void *arg)
+{
+        Band *band = arg;
+        int width = Bit2_width(band->img);
+        int wpr = (width + BIT2_WORD_BITS - 1) / BIT2_WORD_BITS;
+
+        band->capacity = 64;
+        band->runs = malloc(band->capacity * sizeof(*band->runs));
+        band->nruns = 0;
+        if (band->runs == NULL) {
+                band->failed = 1;
+                return NULL;
+        }
+
+        for (int k = 0; k < band->rows; k++) {
+                int row = band->first_row + k;
+                const uint64_t *black = Bit2_row_fast(band->img, row);
+                int col = 0;
+
+                band->row_start[k] = band->nruns;
+                while ((col = next_bit(black, wpr, col, 0)) < width) {
+                        int end = next_bit(black, wpr, col, ~(uint64_t)0);
+
+                        if (band->nruns == band->capacity) {
+                                Run *more = realloc(band->runs,
+                                                    2L * band->capacity
+                                                    * sizeof(*more));
+                                if (more == NULL) {
+                                        band->failed = 1;
+                                        return NULL;
+                                }
+                                band->runs = more;
+                                band->capacity *= 2;
+                        }
+                        band->runs[band->nruns].row = row;
+                        band->runs[band->nruns].left = col;
+                        band->runs[band->nruns].right = end - 1;
+                        band->nruns++;
+                        col = end;
+                }
+        }
+        band->row_start[band->rows] = band->nruns;
+
+        band->parent = malloc((band->nruns + 1L) * sizeof(int));
+        if (band->parent == NULL) {
+                band->failed = 1;
+                return NULL;
+        }
+        for (int i = 0; i < band->nruns; i++) {
+                band->parent[i] = i;
+        }
+
+        for (int k = 1; k < band->rows; k++) {
+                int above = band->row_start[k - 1];
+                int below = band->row_start[k];
+                int end = band->row_start[k + 1];
+
+                union_adjacent(band->parent,
+                               band->runs + above, below - above, above,
+                               band->runs + below, end - below, below);
+        }
+
+        return NULL;
+}
+
+/********** mark_band (thread body) ********
+ * Set in edges (or, in in-place mode, clear in img) every run of the
+ * band whose component touches the border. Bands cover disjoint rows,
+ * so threads write disjoint words; every band is labelled before any
+ * is marked.
+ ************************/
+static void *mark_band(void *arg)
+{
+        Band *band = arg;
+
+        for (int i = 0; i < band->nruns; i++) {
+                if (band->border[band->parent[band->offset + i]]) {
+                        Run *run = &band->runs[i];
+
+                        if (band->edges == NULL) {
+                                uint64_t *row = Bit2_row_fast(band->img,
+                                                              run->row);
+                                Bit2_clear_run_fast(row, run->left,
+                                                    run->right);
+                        }
+                        else {
+                                uint64_t *row = Bit2_row_fast(band->edges,
+                                                              run->row);
+                                Bit2_set_run_fast(row, run->left,
+                                                  run->right);
+                        }
+                }
+        }
+
+        return NULL;
+}
+
+/********** run_bands ********
+ * Run work on every band, one thread per band; the calling thread
+ * takes band 0. A band whose thread cannot be created is run by the
+ * calling thread instead.
+ ************************/
+static void run_bands(Band *bands, int nbands, void *work(void *band))
+{
+        pthread_t *threads = ALLOC((long)nbands * sizeof(*threads));
+        char *started = CALLOC(nbands, sizeof(*started));
+
+        for (int b = 1; b < nbands; b++) {
+                started[b] = pthread_create(&threads[b], NULL, work,
+                                            &bands[b]) == 0;
+        }
+        work(&bands[0]);
+        for (int b = 1; b < nbands; b++) {
+                if (started[b]) {
+                        pthread_join(threads[b], NULL);
+                }
+                else {
+                        work(&bands[b]);
+                }
+        }
+
+        FREE(started);
+        FREE(threads);
+}
+
+/********** find_root / union_roots ********
+ * Union-find over run indices. find_root halves paths as it goes;
+ * union_roots links the larger root under the smaller one.
+ ************************/
+static int find_root(int *parent, int x)
+{
+        while (parent[x] != x) {
+                parent[x] = parent[parent[x]];
+                x = parent[x];
+        }
+        return x;
+}
+
+static void union_roots(int *parent, int a, int b)
+{
+        a = find_root(parent, a);
+        b = find_root(parent, b);
+
+        if (a < b) {
+                parent[b] = a;
+        }
+        else {
+                parent[a] = b;
+        }
+}
+
+/********** union_adjacent ********
+ * Union every run of one row with every run of the next row that it
+ * overlaps. Both lists are sorted left to right, so one merge-style
+ * pass finds all overlapping pairs.
+ *
+ * Parameters:
+ *      int *parent:           union-find array
+ *      const Run *above:      runs of the upper row, n_above of them,
+ *                             whose indices start at above_base
+ *      const Run *below:      runs of the lower row, likewise
+ ************************/
+static void union_adjacent(int *parent, const Run *above, int n_above,
+                           int above_base, const Run *below, int n_below,
+                           int below_base)
+{
+        int i = 0;
+        int j = 0;
+
+        while (i < n_above && j < n_below) {
+                if (above[i].left <= below[j].right
+                    && below[j].left <= above[i].right) {
+                        union_roots(parent, above_base + i, below_base + j);
+                }
+                if (above[i].right < below[j].right) {
+                        i++;
+                }
+                else {
+                        j++;
+                }
+        }
+}
+
+/********** next_bit ********
+ * Return the first column >= col of a packed row whose bit is 1
+ * (flip == 0) or 0 (flip == ~0), or wpr * 64 if there is none. Skips
+ * whole words at a time.
+ *
+ * Notes:
+ *      Padding bits are 0, so a search for 0 stops at width at the
+ *      latest, and a search for 1 never stops in the padding.
+ ************************/
+static int next_bit(const uint64_t *words, int wpr, int col, uint64_t flip)
+{
+        int k = col / BIT2_WORD_BITS;
+
+        if (k >= wpr) {
+                return wpr * BIT2_WORD_BITS;
+        }
+
+        uint64_t word = (words[k] ^ flip)
+                      & (~(uint64_t)0 << (col % BIT2_WORD_BITS));
+        while (word == 0) {
+                if (++k == wpr) {
+                        return wpr * BIT2_WORD_BITS;
+                }
+                word = words[k] ^ flip;
+        }
+        return k * BIT2_WORD_BITS + __builtin_ctzll(word);
+}
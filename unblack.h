@@ -0,0 +1,69 @@
+/**************************************************************
+ *
+ *                       unblack.h
+ *
+ *     Assignment: iii (CS 40 A2)
+ *     Authors:    <tvales01, >
+ *     Date:       <2025-09-25>
+ *
+ *     In-memory black-edge removal, built as libunblack.a. This is
+ *     the core of unblackedges without the command line: it takes a
+ *     bitmap that is already in memory and clears every black pixel
+ *     that is on the border or 4-connected to one. Nothing here
+ *     reads or writes a FILE, and nothing exits.
+ *
+ *     Usage:
+ *       An Unblack_T holds the chosen fill engine and the scratch
+ *       buffers it keeps from one image to the next, so a long-running
+ *       caller should make one per thread and reuse it. It must not be
+ *       used by two threads at once.
+ *
+ *     Errors:
+ *       Checked runtime errors raise Assert_Failed (Hanson assert.h),
+ *       and allocation failures raise Mem_Failed. Hanson exceptions
+ *       unwind only the thread that raises them, so TRY/EXCEPT in the
+ *       caller catches exactly those raised on the calling thread:
+ *         - every CRE of this interface (see unblack.c), since each
+ *           function checks its arguments before any worker thread
+ *           starts;
+ *         - Mem_Failed, including a parallel-engine worker's, which
+ *           is raised again on the calling thread after the join.
+ *       The parallel and steal engines run their fills on pthreads. The
+ *       asserts there guard only the library's internal invariants,
+ *       and a raise on one of those threads aborts the process; so
+ *       does a steal worker's deque that cannot grow.
+ *
+ *     Notes:
+ *       Function contracts and the fill engines are documented in
+ *       unblack.c.
+ *
+ **************************************************************/
+
+#ifndef UNBLACK_INCLUDED
+#define UNBLACK_INCLUDED
+
+#include "bit2.h"
+
+#define T Unblack_T
+typedef struct T *T;
+
+/* How an Unblack_T works; zeroed fields choose the defaults */
+typedef struct Unblack_options {
+        const char *fill;       /* engine name, NULL for the default */
+        int threads;            /* parallel engines; 0 = one per CPU */
+        int inplace;            /* nonzero: no second bitmap */
+} Unblack_options;
+
+extern T Unblack_new(const Unblack_options *options);
+
+extern int Unblack_has_engine(const char *name);
+
+extern void Unblack_free(T *unblack);
+
+extern void Unblack_bit2(T unblack, Bit2_T img);
+
+extern Bit2_T Unblack_rows(T unblack, const unsigned char *rows,
+                           int width, int height);
+
+#undef T
+#endif
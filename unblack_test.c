@@ -0,0 +1,93 @@
+#include <stdbool.h>
+#include <stdio.h>
+#include "bit2.h"
+#include "unblack.h"
+
+const int WIDTH = 10;
+const int HEIGHT = 6;
+
+/*
+ * Raw PBM rows, MSB = leftmost pixel. Two border-connected shapes (top
+ * left, and bottom right reaching in to row 4) and a 2x2 block at
+ * columns 5-6, rows 2-3 that touches neither.
+ */
+const unsigned char ROWS[] = {
+        0x80, 0x00,
+        0xC0, 0x00,
+        0x46, 0x00,
+        0x06, 0x00,
+        0x00, 0x80,
+        0x00, 0xC0,
+};
+
+const char *ENGINES[] = { "bfs", "words", "spans", "parallel", "steal" };
+
+/* Only the interior block is left */
+bool cleaned(Bit2_T img)
+{
+        bool ok = Bit2_width(img) == WIDTH && Bit2_height(img) == HEIGHT;
+
+        for (int row = 0; ok && row < HEIGHT; row++) {
+                for (int col = 0; col < WIDTH; col++) {
+                        int want = col >= 5 && col <= 6 && row >= 2
+                                   && row <= 3;
+                        ok &= Bit2_get(img, col, row) == want;
+                }
+        }
+        return ok;
+}
+
+int main(int argc, char *argv[])
+{
+        (void)argc;
+        (void)argv;
+
+        bool OK = true;
+        int nengines = sizeof(ENGINES) / sizeof(ENGINES[0]);
+
+        for (int k = 0; k < 2 * nengines; k++) {
+                /* every engine twice: with edges, then in place */
+                Unblack_options options = { ENGINES[k % nengines], 2,
+                                            k >= nengines };
+                Unblack_T unblack = Unblack_new(&options);
+
+                Bit2_T img = Unblack_rows(unblack, ROWS, WIDTH, HEIGHT);
+                OK &= cleaned(img);
+
+                /* a reused handle gives the same answer on a new shape */
+                Bit2_T full = Bit2_new(3, 4);
+                for (int row = 0; row < 4; row++) {
+                        for (int col = 0; col < 3; col++) {
+                                Bit2_put(full, col, row, 1);
+                        }
+                }
+                Unblack_bit2(unblack, full);
+                OK &= Bit2_count(full) == 0;
+
+                Unblack_bit2(unblack, img);
+                OK &= cleaned(img);
+
+                Bit2_free(&full);
+                Bit2_free(&img);
+                Unblack_free(&unblack);
+                OK &= unblack == NULL;
+        }
+
+        /* every engine name is known, and only those */
+        for (int k = 0; k < nengines; k++) {
+                OK &= Unblack_has_engine(ENGINES[k]);
+        }
+        OK &= Unblack_has_engine(NULL) && !Unblack_has_engine("dfs")
+              && !Unblack_has_engine("");
+
+        /* NULL options: the default engine */
+        Unblack_T unblack = Unblack_new(NULL);
+        Bit2_T img = Unblack_rows(unblack, ROWS, WIDTH, HEIGHT);
+        OK &= cleaned(img);
+        Bit2_free(&img);
+        Unblack_free(&unblack);
+
+        printf("Unblack is %sOK!\n", (OK ? "" : "NOT "));
+
+        return OK ? 0 : 1;
+}
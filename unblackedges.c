@@ -8,512 +8,1148 @@
  *
  *     Transform PBM input by removing “black edge” pixels. A black
  *     edge pixel is any black pixel on the border, or 4-connected to
- *     another black edge pixel. Algorithm: read PBM with Pnmrdr into
- *     Bit2 img; BFS from all black border pixels over 4-neighbors,
- *     marking them in a same-size Bit2 edges; finally set those img
- *     pixels to white and emit plain PBM (P1).
+ *     another black edge pixel. Reads PBM (P1 or P4) in bulk with
+ *     pnmread into Bit2 img, removes the black edge pixels with
+ *     libunblack (unblack.h), and emits plain PBM (P1).
+ *
+ *     Fill engines (--fill=NAME): bfs (default), words, spans,
+ *     parallel and steal; see unblack.c. --threads=N sets the threads
+ *     of the parallel engines (default one per CPU). --inplace has the
+ *     engine clear edge pixels in img as it finds them, with no edges
+ *     bitmap, halving peak bitmap memory.
+ *
+ *     Streaming mode (--stream):
+ *       Never builds img or edges. Reads one row at a time, splits it
+ *       into black runs, and groups the runs into components with a
+ *       union-find over this row and the one above: a run joins the
+ *       components above that it overlaps, and a component is flagged
+ *       once any of its runs touches the border. Components are
+ *       numbered afresh in every row; each row is spilled to a
+ *       temporary file with its runs and, per component, its fate: the
+ *       component it continues as in the next row, or its flag if it
+ *       ends there. A backward pass over the spill resolves every fate
+ *       to a final flag, and a forward pass prints every run whose
+ *       component never touched the border. Memory is a few arrays of
+ *       (width + 1) / 2 entries, independent of the image height.
+ *
+ *     Batch mode (--batch=OUTDIR):
+ *       Unblacks many files in one process: the files named on the
+ *       command line, or the paths listed on stdin. A pool of threads
+ *       takes files one at a time; each thread keeps its img and its
+ *       Unblack_T (a Workspace) from file to file, reshaping rather
+ *       than reallocating their buffers.
+ *
+ *       With --pipeline, a batch instead runs as three stages joined by
+ *       bounded single-producer/single-consumer queues: one thread
+ *       parses file k + 1 while another fills file k and a third
+ *       writes file k - 1. A fixed set of PIPELINE_DEPTH images
+ *       circulates, so memory stays bounded however long the batch.
  *
  *     Dependencies:
- *       pnmrdr.h, bit2.h, assert.h, mem.h, queue.h, stdlib/stdio.
+ *       unblack.h, pnmrdr.h (streaming mode), pnmread.h, pnmwrite.h,
+ *       bit2.h, bit2_fast.h, assert.h, mem.h, queue.h (pipeline),
+ *       stdlib/stdio/string, pthread.h (batch modes),
+ *       unistd.h.
  *
  *     Checked runtime errors (CREs):
- *       >1 argument; not PBM (md.type != Pnmrdr_bit); width<=0 or
- *       height<=0; file open failure; reader errors.
+ *       >1 file argument without --batch; batch input or output file
+ *       cannot be opened; unknown option or fill engine; --threads not
+ *       a positive integer; --pipeline without --batch or with
+ *       --stream; spill file cannot be created or written; not PBM
+ *       (md.type != Pnmrdr_bit); width<=0 or height<=0; file open
+ *       failure; reader errors.
  *
  *     Output:
- *       Prints P1 header and pixels with spaces; newline at end of row.
+ *       Plain PBM (P1): pixels as 0/1 digits, newline at end of row. With
+ *       --raw, raw PBM (P4) instead. Written through pnmwrite's buffer.
  *
  **************************************************************/
 
+#define _POSIX_C_SOURCE 200809L
+
+#include <limits.h>
+#include <pthread.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
 
 #include "assert.h"
 #include "bit2.h"
+#include "bit2_fast.h"
 #include "pnmrdr.h"
+#include "pnmread.h"
+#include "pnmwrite.h"
 #include "queue.h"
+#include "unblack.h"
 #include "mem.h"
 
-static void check_input(FILE *in);
-static void store_in_bit2(Pnmrdr_T file);
-static void print_pbm(Bit2_T img);
-static void print_bit(int col, int row, Bit2_T bit2, int bit, void *cl);
-static void check_black_edge(Bit2_T img);
-static void enq_black(Bit2_T img, int col, int row, Queue_T bitQ, Bit2_T edges);
-static void check_black_neighbors(Bit2_T img, Queue_T bitQ, Bit2_T edges);
-static void black_to_white(int col, int row, Bit2_T bit2, int bit, void *cl);
-
-/* Struct holds the index of a bit in bit2 */
-typedef struct Index {
-        int col;
-        int row;
-} *Index;
+/*
+ * Buffers kept from one image to the next: the img bitmap (reshaped
+ * to each image, see Bit2_reshape) and the Unblack_T with the fill
+ * engine and its scratch buffers. img is NULL until the first image.
+ */
+typedef struct Workspace {
+        Bit2_T img;
+        Unblack_T unblack;
+} Workspace;
 
-/********** main ********
- *
- * Parameters:
- *      int argc:     number of arguments given in the command-line
- *      char *argv[]: array that stores all the arguments
- *
- * Return:
- *      EXIT_SUCCESS (0) if program runs successfully, CRE otherwise
- *
- * Expects:
- *      a pbm file given in the command-line or stdin
- * 
- * Notes:
- *      CRE if more than one argument given, input file cannot be opened, error
- *      encountered reading file, memory allocation fails
- ************************/
-};
+/*
+ * A pipeline queue: the lock-free SPSCQ carries the jobs, and a stage
+ * that finds it empty (or full) sleeps on changed until the other
+ * stage has dequeued or enqueued
+ */
+typedef struct Channel {
+        SPSCQ_T queue;
+        pthread_mutex_t lock;
+        pthread_cond_t changed;
+} Channel;
+
+static void check_input(FILE *in, FILE *out, int stream, Workspace *ws);
+static void store_in_bit2(FILE *in, FILE *out, Workspace *ws);
+static void free_workspace(Workspace *ws);
+static void run_batch(const char *outdir, char **paths, int npaths,
+                      const Unblack_options *options, int stream);
+static void *batch_worker(void *arg);
+static char **read_manifest(FILE *in, int *npaths);
+static char *output_path(const char *outdir, const char *path);
+static void run_pipeline(const char *outdir, char **paths, int npaths,
+                         const Unblack_options *options);
+static void *read_stage(void *arg);
+static void *write_stage(void *arg);
+static void channel_init(Channel *channel, int capacity);
+static void channel_destroy(Channel *channel);
+static void *take(Channel *channel);
+static void put(Channel *channel, void *elem);
+static void wake(Channel *channel);
+static int parse_count(const char *text);
+static int thread_count(int threads);
+
+/* Nonzero (--raw) to write raw P4 instead of plain P1 */
+static int raw_output = 0;
 
-typedef struct Index *Index;
+/* A black run of the streaming mode: columns left..right, in label */
+typedef struct Segment {
+        int left;
+        int right;
+        int label;              /* component number within its row */
+} Segment;
+
+/*
+ * One row of the streaming mode: its runs, and per component whether
+ * it touches the border so far and what becomes of it below (FATE_*)
+ */
+typedef struct Row {
+        Segment *segs;
+        int nsegs;
+        int ncomps;
+        char *border;
+        int *fate;
+} Row;
+
+/* A fate >= 0 is the component's number in the next row */
+#define FATE_CLEAR (-1)         /* ended without touching the border */
+#define FATE_BORDER (-2)        /* ended touching the border */
+
+/*
+ * Union-find over two rows: the components of the row above, then the
+ * runs of this row, with a border flag and this row's component
+ * number per root
+ */
+typedef struct Labels {
+        int *parent;
+        char *border;
+        int *comp;
+} Labels;
+
+static void stream_unblack(Pnmrdr_T file, FILE *out);
+static int read_segments(Pnmrdr_T file, int width, Segment *segs);
+static void label_row(Labels *labels, Row *above, Row *row, int edge_row,
+                      int width);
+static int find_label(Labels *labels, int label);
+static void union_labels(Labels *labels, int a, int b);
+static void spill_row(FILE *spill, const Row *row);
+static void resolve_fates(FILE *spill, int height, Row *below, Row *row);
+static void spill_write(FILE *spill, const void *p, size_t size, size_t n);
+static void spill_read(FILE *spill, void *p, size_t size, size_t n);
+static void print_segments(const Row *row, uint64_t *line, int wpr);
 
 /********** main ********
  * Transform PBM input by removing black edge pixels (predicate program).
  *
  * Parameters:
- *      int argc, char *argv[]:
- *          0 args  -> read PBM from stdin
- *          1 arg   -> read PBM from argv[1]
- *          >1 args -> CRE
+ *      int argc, char *argv[]: [--fill=NAME] [--threads=N] [--stream]
+ *                              [--inplace] [--raw] [--batch=OUTDIR]
+ *                              [--pipeline] [pbmfile...]
+ *          --fill=NAME   -> choose the fill engine (see unblack.c)
+ *          --threads=N   -> threads for the parallel engines
+ *          --stream      -> bounded-memory streaming mode (ignores --fill)
+ *          --inplace     -> clear edge pixels in img during the fill,
+ *                           with no second bitmap (see unblack.c)
+ *          --raw         -> write raw PBM (P4) instead of plain (P1)
+ *          --batch=OUTDIR -> batch mode: unblack every pbmfile (or, if
+ *                           none, every path listed one per line on
+ *                           stdin) into OUTDIR under its own name,
+ *                           --threads=N files at a time
+ *          --pipeline    -> with --batch: overlap reading, filling and
+ *                           writing in three stage threads instead
+ *          no file       -> read PBM from stdin
+ *          one file      -> read PBM from that file
+ *          >1 files      -> CRE unless --batch
  *
  * Returns:
- *      EXIT_SUCCESS on normal completion after writing a plain PBM (P1) to
- *      stdout.
+ *      EXIT_SUCCESS on normal completion after writing the PBM to stdout.
  *
  * Effects:
- *      Opens input file when provided; builds a Pnmrdr; validates PBM type;
- *      constructs Bit2 image; performs edge-removal; prints P1 PBM to stdout.
+ *      Opens input file when provided; reads and validates the PBM;
+ *      constructs Bit2 image; performs edge-removal with Unblack_bit2;
+ *      writes the PBM (P1,
+ *      or P4 with --raw) to stdout.
  *
  * Checked run-time errors (CRE):
- *      - argc > 2
+ *      - more than one file without --batch, or an unknown option or
+ *        engine
+ *      - --pipeline without --batch, or with --stream
+ *      - --threads value that is not a positive integer
  *      - fopen failure when a filename is given
  *      - Pnmrdr rejects input or md.type != Pnmrdr_bit
  *      - width <= 0 or height <= 0
  ************************/
 int main(int argc, char *argv[])
 {
-        assert(argc <= 2);
+        Unblack_options options = { NULL, 0, 0 };
+        int stream = 0;
+        const char *outdir = NULL;
+        int pipelined = 0;
+        char **paths = ALLOC(argc * (long)sizeof(*paths));
+        int npaths = 0;
+
+        for (int i = 1; i < argc; i++) {
+                if (strncmp(argv[i], "--fill=", 7) == 0) {
+                        options.fill = argv[i] + 7;
+                }
+                else if (strncmp(argv[i], "--threads=", 10) == 0) {
+                        options.threads = parse_count(argv[i] + 10);
+                }
+                else if (strcmp(argv[i], "--stream") == 0) {
+                        stream = 1;
+                }
+                else if (strcmp(argv[i], "--inplace") == 0) {
+                        options.inplace = 1;
+                }
+                else if (strcmp(argv[i], "--raw") == 0) {
+                        raw_output = 1;
+                }
+                else if (strncmp(argv[i], "--batch=", 8) == 0) {
+                        outdir = argv[i] + 8;
+                        assert(*outdir != '\0');
+                }
+                else if (strcmp(argv[i], "--pipeline") == 0) {
+                        pipelined = 1;
+                }
+                else {
+                        assert(argv[i][0] != '-' || argv[i][1] == '\0');
+                        paths[npaths++] = argv[i];
+                }
+        }
 
+        assert(!pipelined || (outdir != NULL && !stream));
+        /* checked before any input is read, so a bad --fill fails first */
+        assert(Unblack_has_engine(options.fill));
+
+        if (outdir != NULL) {
+                char **listed = NULL;
+
+                if (npaths == 0) {
+                        listed = read_manifest(stdin, &npaths);
+                }
+                if (pipelined) {
+                        run_pipeline(outdir, listed ? listed : paths, npaths,
+                                     &options);
+                }
+                else {
+                        run_batch(outdir, listed ? listed : paths, npaths,
+                                  &options, stream);
+                }
+                if (listed != NULL) {
+                        for (int i = 0; i < npaths; i++) {
+                                FREE(listed[i]);
+                        }
+                        FREE(listed);
+                }
+                FREE(paths);
+                return EXIT_SUCCESS;
+        }
+
+        assert(npaths <= 1);
         FILE *in = NULL;
 
-        if (argc == 2) {
-                in = fopen(argv[1], "rb");
+        if (npaths == 1) {
+                in = fopen(paths[0], "rb");
                 assert(in != NULL);
         }
         else {
                 in = stdin;
         }
 
-        check_input(in);
+        Workspace ws = { NULL, Unblack_new(&options) };
+        check_input(in, stdout, stream, &ws);
+        free_workspace(&ws);
         fclose(in);
+        FREE(paths);
 
         return EXIT_SUCCESS;
 }
 
-/********** check_input ********
- *
- * Checks if the given file is a valid PBM file. 
+/********** parse_count ********
+ * Return the positive integer spelled by text.
  *
- * Parameters:
- *      FILE *in: a pointer to a file object (PBM file)
- *
- * Return:
- *      none
- *
- * Notes:
- *      This function will free the memory it allocates.
- * 
- *      CRE if input is not a valid pbm
- * 
+ * CRE
+ *      CRE if text is not a positive decimal integer that fits an int
+ ************************/
+static int parse_count(const char *text)
+{
+        char *end;
+        long n = strtol(text, &end, 10);
+
+        assert(end != text && *end == '\0' && n > 0 && n <= INT_MAX);
+        return (int)n;
+}
+
+/********** thread_count ********
+ * Return the worker threads a batch should use: threads (--threads=N)
+ * if nonzero, else the number of online CPUs (at least 1).
  ************************/
-static void check_input(FILE *in)
+static int thread_count(int threads)
+{
+        if (threads > 0) {
+                return threads;
+        }
+
+        long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        return cpus > 0 && cpus <= INT_MAX ? (int)cpus : 1;
+}
+
 /********** check_input ********
  * Validate that input is a PBM (bitmap) and dispatch reading/processing.
  *
  * Parameters:
- *      FILE *in: open stream (stdin or file)
+ *      FILE *in:      open stream (stdin or file)
+ *      FILE *out:     where the result goes
+ *      int stream:    nonzero to use streaming mode instead of an engine
+ *      Workspace *ws: image and engine to reuse; updated for the next
+ *                     call
  *
  * Returns:
  *      None
  *
  * Effects:
- *      Constructs a Pnmrdr, checks md.type == Pnmrdr_bit, calls store_in_bit2.
+ *      Streaming mode constructs a Pnmrdr, checks md.type ==
+ *      Pnmrdr_bit and calls stream_unblack, so rows arrive one at a
+ *      time. Otherwise calls store_in_bit2, which loads the whole image
+ *      with pnmread.
  *
  * CRE
- *      CRE if Pnmrdr rejects input or type is not PBM
+ *      CRE if the reader rejects input or type is not PBM
  ************************/
-void check_input(FILE *in)
+static void check_input(FILE *in, FILE *out, int stream, Workspace *ws)
 {
+        if (!stream) {
+                store_in_bit2(in, out, ws);
+                return;
+        }
+
         Pnmrdr_T file = Pnmrdr_new(in);
         Pnmrdr_mapdata data = Pnmrdr_data(file);
         assert(data.type == Pnmrdr_bit);
+        (void)data;
 
-        store_in_bit2(file);
+        stream_unblack(file, out);
 
         Pnmrdr_free(&file);
 }
 
 /********** store_in_bit2 ********
- *
- * Stores all the pixels from the given file in Bit2_T
+ * Read a PBM into a Bit2 grid and run the unblackedges transform.
  *
  * Parameters:
- *      Pnmrdr_T file: the opened file that's ready to be read
+ *      FILE *in:      open stream at the start of a P1 or P4 image
+ *      FILE *out:     where the result goes
+ *      Workspace *ws: image and engine to reuse
  *
- * Return:
- *      none
+ * Returns:
+ *      None
  *
- * Expects:
- *      a valid pbm file that has been opened
+ * Effects:
+ *      Loads ws->img in bulk with Pnmread_bit2_into (reusing its
+ *      storage); calls Unblack_bit2(); writes the result with
+ *      Pnmwrite_bit2 (P1, or P4 with --raw).
  *
- * Notes:
- *      this function will free the memory it allocates. the 2d array from this
- *      function is passed and used in other functions.
- * 
- *      this function will also call the print_pbm function to print the result
- * 
- *      CRE if width or height <= 0     
- * 
+ * CRE
+ *      CRE if input is not a well-formed PBM (see pnmread.c)
  ************************/
-static void store_in_bit2(Pnmrdr_T file)
+static void store_in_bit2(FILE *in, FILE *out, Workspace *ws)
+{
+        /* 2D bit array that will store the original image*/
+        ws->img = Pnmread_bit2_into(in, ws->img);
 
-/********** store_in_bit2 ********
- * Read PBM pixels into a Bit2 grid and run the unblackedges transform.
+        Unblack_bit2(ws->unblack, ws->img);
+        Pnmwrite_bit2(out, ws->img, raw_output);
+}
+
+/********** free_workspace ********
+ * Free every buffer held in ws and reset its fields to NULL.
+ ************************/
+static void free_workspace(Workspace *ws)
+{
+        if (ws->img != NULL) {
+                Bit2_free(&ws->img);
+        }
+        if (ws->unblack != NULL) {
+                Unblack_free(&ws->unblack);
+        }
+}
+
+/*
+ * Shared state of a batch: workers take the next unclaimed path under
+ * lock, so a slow page never holds up the rest.
+ */
+typedef struct Batch {
+        const char *outdir;
+        char **paths;
+        int npaths;
+        int next;
+        pthread_mutex_t lock;
+        const Unblack_options *options;
+        int stream;
+} Batch;
+
+/********** run_batch ********
+ * Unblack every file in paths into outdir on a pool of threads.
  *
  * Parameters:
- *      Pnmrdr_T file: bitmap reader (width, height > 0)
- *
- * Returns:
- *      None
+ *      const char *outdir: existing directory; the result for a/b/x.pbm
+ *                          is written to outdir/x.pbm
+ *      char **paths:       npaths input files
+ *      const Unblack_options *options: engine for every worker
+ *      int stream:         as check_input
  *
  * Effects:
- *      Allocates Bit2 img; fills from Pnmrdr_get; calls check_black_edge();
- *      prints P1 PBM via print_pbm(); frees img.
+ *      Starts min(thread_count(), npaths) workers, the caller being one
+ *      of them (batch_worker). Each worker keeps one Workspace for all
+ *      of its files, so after its largest page it allocates nothing
+ *      per file but what the reader and writer need.
  *
- * CRE
- *      CRE if width/height <= 0 or reader errors
+ * Notes:
+ *      The parallel engines also use --threads threads per page;
+ *      with --batch the single-threaded engines are usually the better
+ *      fit, since the pages already keep every CPU busy.
  ************************/
-void store_in_bit2(Pnmrdr_T file)
+static void run_batch(const char *outdir, char **paths, int npaths,
+                      const Unblack_options *options, int stream)
 {
-        Pnmrdr_mapdata data = Pnmrdr_data(file);
-        assert(data.width > 0 && data.height > 0);
-        int width = data.width;
-        int height = data.height;
+        Batch batch = { outdir, paths, npaths, 0,
+                        PTHREAD_MUTEX_INITIALIZER, options, stream };
+        int nworkers = thread_count(options->threads);
 
-        /* 2D bit array that will store the original image*/
-        Bit2_T img = Bit2_new(width, height);
+        if (nworkers > npaths) {
+                nworkers = npaths > 0 ? npaths : 1;
+        }
+
+        /* A worker whose thread cannot start leaves its files to others */
+        pthread_t *threads = ALLOC((long)nworkers * sizeof(*threads));
+        char *started = CALLOC(nworkers, sizeof(*started));
 
-        /* Walk through each bit and store in Bit2 */
-        for (int row = 0; row < height; row++) {
-                for (int col = 0; col < width; col++) {
-                        int bit = Pnmrdr_get(file);
-                        Bit2_put(img, col, row, bit);
+        for (int w = 1; w < nworkers; w++) {
+                started[w] = pthread_create(&threads[w], NULL, batch_worker,
+                                            &batch) == 0;
+        }
+        batch_worker(&batch);
+        for (int w = 1; w < nworkers; w++) {
+                if (started[w]) {
+                        pthread_join(threads[w], NULL);
                 }
         }
 
-        check_black_edge(img);
-        print_pbm(img);
-
-        Bit2_free(&img);
+        pthread_mutex_destroy(&batch.lock);
+        FREE(started);
+        FREE(threads);
 }
 
-/********** check_black_edge ********
- *
- * Check and store each black edge pixel of the image and in a parallel bit2
- * array and queue which will be used to track neighboring black pixels.
+/********** batch_worker (thread body) ********
+ * Claim and process files of a Batch until none are left.
  *
- * Parameters:
- *      Bit2_T img: the bit2 array that stores each pixel of the image
- *
- * Return:
- *      none
- *
- * Expects:
- *      a valid Bit2_T that has been initialized
- *
- * Notes:
- *      this function dynamically allocates memory for Queue_T which will be
- *      used for checking black neighbors. the memory is freed in this function
- *      HOWEVER, the memory of the pointers in the queue will NOT be freed in 
- *      this function
- * 
- *      this function also creates another Bit2_T which is a parallel to the 
- *      given array and marks traversed back pixels. its memory is also freed 
- *      in this function.
- * 
+ * CRE
+ *      CRE if an input cannot be opened, its output cannot be created
+ *      or written, or an input is not a PBM; this ends the whole batch
  ************************/
-static void check_black_edge(Bit2_T img)
+static void *batch_worker(void *arg)
+{
+        Batch *batch = arg;
+        Workspace ws = { NULL, Unblack_new(batch->options) };
+
+        for (;;) {
+                pthread_mutex_lock(&batch->lock);
+                int i = batch->next < batch->npaths ? batch->next++ : -1;
+                pthread_mutex_unlock(&batch->lock);
+                if (i < 0) {
+                        break;
+                }
 
-/********** check_black_edge ********
- * Mark all border-connected black pixels using BFS and remove them.
+                const char *path = batch->paths[i];
+                char *out_path = output_path(batch->outdir, path);
+
+                FILE *in = fopen(path, "rb");
+                assert(in != NULL);
+                FILE *out = fopen(out_path, "wb");
+                assert(out != NULL);
+
+                check_input(in, out, batch->stream, &ws);
+
+                fclose(in);
+                int rc = fclose(out);
+                assert(rc == 0);
+                (void)rc;
+                FREE(out_path);
+        }
+
+        free_workspace(&ws);
+        return NULL;
+}
+
+/********** output_path ********
+ * Return a new string naming outdir/<base name of path>.
+ ************************/
+static char *output_path(const char *outdir, const char *path)
+{
+        const char *name = strrchr(path, '/');
+        name = name == NULL ? path : name + 1;
+
+        long length = strlen(outdir) + strlen(name) + 2;
+        char *out_path = ALLOC(length);
+        snprintf(out_path, length, "%s/%s", outdir, name);
+
+        return out_path;
+}
+
+/* Images in flight at once in a pipelined batch */
+#define PIPELINE_DEPTH 4
+
+/* One image moving through the pipeline; img is reused by later files */
+typedef struct Job {
+        const char *path;
+        Bit2_T img;
+} Job;
+
+/*
+ * Stages of a pipelined batch and the bounded queues between them.
+ * Jobs go read -> parsed -> fill -> filled -> write -> free_jobs ->
+ * read; each queue has one producer and one consumer. NULL on parsed
+ * and filled marks the end of the batch.
+ */
+typedef struct Pipeline {
+        const char *outdir;
+        char **paths;
+        int npaths;
+        Channel free_jobs;
+        Channel parsed;
+        Channel filled;
+} Pipeline;
+
+/********** run_pipeline ********
+ * Unblack every file in paths into outdir with one thread per stage:
+ * read_stage parses file k + 1 while the caller fills file k and
+ * write_stage writes file k - 1.
  *
  * Parameters:
- *      Bit2_T img: input/output bitmap (1=black, 0=white)
- *
- * Returns:
- *      None
+ *      As run_batch, without stream
  *
  * Effects:
- *      Allocates a same-size Bit2 edges marking edge-connected black pixels.
- *      Enqueues black border pixels; runs BFS over 4-neighbors; then
- *      calls remove_black() to write 0s at marked locations; frees edges.
+ *      PIPELINE_DEPTH jobs circulate through the stages, so at most
+ *      that many images are in memory however long the batch; a stage
+ *      that gets ahead sleeps until a job comes back (see take/put). The
+ *      fill stage keeps one Unblack_T for all the files. If a stage
+ *      thread cannot be created the files are run through run_batch
+ *      instead.
  ************************/
-void check_black_edge(Bit2_T img)
+static void run_pipeline(const char *outdir, char **paths, int npaths,
+                         const Unblack_options *options)
 {
-        /* Queue to check each black edge pixel */
-        Queue_T bitQ = Queue_new();
+        Job jobs[PIPELINE_DEPTH];
+        Pipeline pipeline;
+
+        pipeline.outdir = outdir;
+        pipeline.paths = paths;
+        pipeline.npaths = npaths;
+        channel_init(&pipeline.free_jobs, PIPELINE_DEPTH);
+        channel_init(&pipeline.parsed, PIPELINE_DEPTH);
+        channel_init(&pipeline.filled, PIPELINE_DEPTH);
+
+        for (int k = 0; k < PIPELINE_DEPTH; k++) {
+                jobs[k].path = NULL;
+                jobs[k].img = NULL;
+                put(&pipeline.free_jobs, &jobs[k]);
+        }
+
         /*
-         * Bit2 is a parallel array to original image that will mark the bits 
-         * that need to be unblacked
+         * The writer starts first: if the reader then cannot start,
+         * nothing has been parsed yet and no work is thrown away
          */
-        Bit2_T edges = Bit2_new(Bit2_width(img), Bit2_height(img));
+        pthread_t reader, writer;
+        int have_writer = pthread_create(&writer, NULL, write_stage,
+                                         &pipeline) == 0;
+        int have_reader = have_writer
+                          && pthread_create(&reader, NULL, read_stage,
+                                            &pipeline) == 0;
+
+        if (have_reader) {
+                Unblack_T unblack = Unblack_new(options);
+                Job *job;
 
-        /* The two for loops check for black pixels at the very edge */
-        for (int col = 0; col < Bit2_width(img); col++)  {
-                enq_black(img, col, 0, bitQ, edges);
-                enq_black(img, col, Bit2_height(img) - 1, bitQ, edges);
+                while ((job = take(&pipeline.parsed)) != NULL) {
+                        Unblack_bit2(unblack, job->img);
+                        put(&pipeline.filled, job);
+                }
+                put(&pipeline.filled, NULL);
+
+                Unblack_free(&unblack);
+                pthread_join(writer, NULL);
+                pthread_join(reader, NULL);
+        }
+        else {
+                if (have_writer) {
+                        /* the writer only waits for jobs: end it */
+                        put(&pipeline.filled, NULL);
+                        pthread_join(writer, NULL);
+                }
+                run_batch(outdir, paths, npaths, options, 0);
         }
 
-        for (int row = 0; row < Bit2_height(img); row++) {
-                enq_black(img, 0, row, bitQ, edges);
-                enq_black(img, Bit2_width(img) - 1, row, bitQ, edges);   
+        for (int k = 0; k < PIPELINE_DEPTH; k++) {
+                if (jobs[k].img != NULL) {
+                        Bit2_free(&jobs[k].img);
+                }
         }
+        channel_destroy(&pipeline.free_jobs);
+        channel_destroy(&pipeline.parsed);
+        channel_destroy(&pipeline.filled);
+}
 
-        check_black_neighbors(img, bitQ, edges);
-        Bit2_map_row_major(edges, black_to_white, img);
+/********** read_stage (thread body) ********
+ * Parse each file into a free job's img and pass it on; then pass
+ * NULL.
+ *
+ * CRE
+ *      CRE if an input cannot be opened or is not a PBM
+ ************************/
+static void *read_stage(void *arg)
+{
+        Pipeline *pipeline = arg;
 
-        Bit2_free(&edges);
-        Queue_free(&bitQ);
+        for (int i = 0; i < pipeline->npaths; i++) {
+                Job *job = take(&pipeline->free_jobs);
+                FILE *in = fopen(pipeline->paths[i], "rb");
+                assert(in != NULL);
+
+                job->path = pipeline->paths[i];
+                job->img = Pnmread_bit2_into(in, job->img);
+                fclose(in);
+
+                put(&pipeline->parsed, job);
+        }
+        put(&pipeline->parsed, NULL);
+
+        return NULL;
 }
 
-/********** black_to_white ********
- *
- * Callback function for the Bit2 map function that which convert all black edge
- * pixels to white.
+/********** write_stage (thread body) ********
+ * Write each filled job to outdir and return the job to the reader,
+ * until NULL arrives.
  *
- * Parameters:
- *      int col:     the col index of the current pixel
- *      int row:     the row index of the current pixel
- *      Bit2_T bit2: the Bit2 array that marks the black pixels to be unblacked
- *      int bit:     the bit value of the current pixel
- *      void *cl:    this void * is the Bit2 array of the original image
- *
- * Return:
- *      none
- *
- * Notes:
- *      this function will update the content of the Bit2 array given as the 
- *      closure variable. It converts all the black edge pixels to white
- * 
+ * CRE
+ *      CRE if an output file cannot be created or written
  ************************/
-static void black_to_white(int col, int row, Bit2_T bit2, int bit, void *cl)
-/********** remove_black ********
- * For every marked edge pixel, set corresponding img pixel to white (0).
- *
- * Parameters:
- *      Bit2_T img, Bit2_T edges
- *
- * Returns:
- *      None
+static void *write_stage(void *arg)
+{
+        Pipeline *pipeline = arg;
+        Job *job;
+
+        while ((job = take(&pipeline->filled)) != NULL) {
+                char *out_path = output_path(pipeline->outdir, job->path);
+                FILE *out = fopen(out_path, "wb");
+                assert(out != NULL);
+
+                Pnmwrite_bit2(out, job->img, raw_output);
+                int rc = fclose(out);
+                assert(rc == 0);
+                (void)rc;
+                FREE(out_path);
+
+                put(&pipeline->free_jobs, job);
+        }
+
+        return NULL;
+}
+
+/********** channel_init / channel_destroy ********
+ * Set up an empty channel of capacity jobs / release it.
  ************************/
-void remove_black(Bit2_T img, Bit2_T edges)
+static void channel_init(Channel *channel, int capacity)
 {
-        Bit2_map_row_major(edges, black_to_white, img);
+        channel->queue = SPSCQ_new(capacity);
+        pthread_mutex_init(&channel->lock, NULL);
+        pthread_cond_init(&channel->changed, NULL);
 }
 
+static void channel_destroy(Channel *channel)
+{
+        SPSCQ_free(&channel->queue);
+        pthread_mutex_destroy(&channel->lock);
+        pthread_cond_destroy(&channel->changed);
+}
 
-/********** black_to_white (map callback) ********
- * If the edges bit at (col,row) is 1, set img(col,row) to 0.
+/********** take / put ********
+ * Dequeue from / enqueue on a pipeline channel, sleeping while it is
+ * empty / full.
  *
- * Parameters:
- *      int col, int row, Bit2_T edges, int bit, void *cl (img as closure)
+ * Notes:
+ *      The lock-free SPSCQ is tried first and the lock is only taken
+ *      to wait. A waiter retries under the lock before it sleeps, and
+ *      wake signals under the lock after every transfer, so a wakeup
+ *      cannot fall between the retry and the sleep. With one producer
+ *      and one consumer, at most one stage waits on a channel: it
+ *      cannot be empty and full at once.
  ************************/
-void black_to_white(int col, int row, Bit2_T bit2, int bit, void *cl)
+static void *take(Channel *channel)
 {
-        (void)bit2;
-        /*
-         * If the current bit in the parallel array is 1, it means that pixel  
-         * should be unblacked in the original img
-         */
-        if (bit == 1) {
-                Bit2_put((Bit2_T)cl, col, row, 0);
+        void *elem;
+
+        if (!SPSCQ_try_deq(channel->queue, &elem)) {
+                pthread_mutex_lock(&channel->lock);
+                while (!SPSCQ_try_deq(channel->queue, &elem)) {
+                        pthread_cond_wait(&channel->changed, &channel->lock);
+                }
+                pthread_mutex_unlock(&channel->lock);
         }
+        wake(channel);
+        return elem;
 }
 
-/********** check_black_neighbors ********
- *
- * Checks all the neighbors of black edge pixels and mark them in the parallel
- * array
- *
- * Parameters:
- *      Bit2_T img:   the bit2 array of the original image
- *      Queue_T bitQ: the queue used to track black neighbors
- *      Bit2_T edges: the bit2 array parallel to img to mark traversed black 
- *                    edges
- *
- * Return:
- *      none
- *
- * Notes:
- *      this function calls another function that enqueues the queue and modify
- *      the parallel array
- * 
- *      all memory stored in the queue will be freed after this function.
- * 
+static void put(Channel *channel, void *elem)
+{
+        if (!SPSCQ_try_enq(channel->queue, elem)) {
+                pthread_mutex_lock(&channel->lock);
+                while (!SPSCQ_try_enq(channel->queue, elem)) {
+                        pthread_cond_wait(&channel->changed, &channel->lock);
+                }
+                pthread_mutex_unlock(&channel->lock);
+        }
+        wake(channel);
+}
+
+/********** wake ********
+ * Wake the other stage if it sleeps on channel.
  ************************/
-static void check_black_neighbors(Bit2_T img, Queue_T bitQ, Bit2_T edges)
-/********** check_black_neighbors ********
- * BFS pop from queue and examine 4-neighbors, enqueueing newly discovered
- * edge-connected black pixels.
- *
- * Parameters:
- *      Bit2_T img, Queue_T bitQ, Bit2_T edges
- *
- * Returns:
- *      None
+static void wake(Channel *channel)
+{
+        pthread_mutex_lock(&channel->lock);
+        pthread_cond_signal(&channel->changed);
+        pthread_mutex_unlock(&channel->lock);
+}
+
+/********** read_manifest ********
+ * Read a batch manifest: one input path per line; empty lines are
+ * skipped. Returns a new array of new strings and sets *npaths.
  ************************/
-void check_black_neighbors(Bit2_T img, Queue_T bitQ, Bit2_T edges)
+static char **read_manifest(FILE *in, int *npaths)
 {
-        /* Breadth-first traversal to check all neighbors*/
-        while (!Queue_empty(bitQ)) {
-                Index i = Queue_deq(bitQ);
-                int col = i->col;
-                int row = i->row;
-
-                /* Check if the 4 neighbors are black */
-                if (col - 1 > 0) {
-                        enq_black(img, col - 1, row, bitQ, edges);
-                if (col - 1 >= 0) {
-                        enq_if_black(img, col - 1, row, bitQ, edges);
-                }
-                if (col + 1 < Bit2_width(img) - 1) {
-                        enq_black(img, col + 1, row, bitQ, edges);
-                if (col + 1 < Bit2_width(img)) {
-                        enq_if_black(img, col + 1, row, bitQ, edges);
-                }
-                if (row - 1 > 0) {
-                        enq_black(img, col, row - 1, bitQ, edges);
-                if (row - 1 >= 0) {
-                        enq_if_black(img, col, row - 1, bitQ, edges);
-                }
-                if (row + 1 < Bit2_height(img) - 1) {
-                        enq_black(img, col, row + 1, bitQ, edges);
-                if (row + 1 < Bit2_height(img)) {
-                        enq_if_black(img, col, row + 1, bitQ, edges);
-                }
-                FREE(i);
+        int capacity = 64;
+        char **paths = ALLOC(capacity * (long)sizeof(*paths));
+        char *line = NULL;
+        size_t size = 0;
+        ssize_t length;
+
+        *npaths = 0;
+        while ((length = getline(&line, &size, in)) >= 0) {
+                while (length > 0 && (line[length - 1] == '\n'
+                                      || line[length - 1] == '\r')) {
+                        line[--length] = '\0';
+                }
+                if (length == 0) {
+                        continue;
+                }
+                if (*npaths == capacity) {
+                        capacity *= 2;
+                        RESIZE(paths, capacity * (long)sizeof(*paths));
+                }
+                paths[*npaths] = ALLOC(length + 1);
+                memcpy(paths[*npaths], line, length + 1);
+                (*npaths)++;
         }
+
+        free(line);
+        return paths;
 }
 
-/********** enq_black ********
- *
- * Enqueues the pixel at the given index if it's black and has not been 
- * traversed yet
+/********** stream_unblack ********
+ * Streaming mode: remove black edge pixels holding only two rows of
+ * runs in memory (see top of file).
  *
  * Parameters:
- *      Bit2_T img:   the bit2 array of the original image
- *      int col:      the column index of the pixel to be checked
- *      int row:      the row index of the pixel to be checked
- *      Queue_T bitQ: the queue used to track black neighbors
- *      Bit2_T edges: the parallel bit2 array of img to mark traversed black 
- *                    edge pixels
- *
- * Return:
- *      none
+ *      Pnmrdr_T file: bitmap reader (width, height > 0)
+ *      FILE *out:     where the result goes
  *
- * Expects:
- *      a valid index of img
+ * Effects:
+ *      Pass 1 reads each row, labels its runs against the row above
+ *      (label_row) and spills the row above, whose fates are then
+ *      known, to an anonymous tmpfile. Pass 2 walks the spill from the
+ *      last row up, replacing every fate with the final one
+ *      (resolve_fates). Pass 3 reads the spill forward and writes the
+ *      PBM to out, writing a run as black only if its component's fate
+ *      is FATE_CLEAR.
  *
  * Notes:
- *      this function might enqueue to the given queue and update edges.
- * 
- ************************/
-static void enq_black(Bit2_T img, int col, int row, Queue_T bitQ, Bit2_T edges)
-/********** enq_if_black ********
- * If (col,row) is black in img and unmarked in edges, mark and enqueue.
- *
- * Parameters:
- *      Bit2_T img, int col, int row, Queue_T bitQ, Bit2_T edges
- *
- * Returns:
- *      None
+ *      Component numbers restart in every row, so every buffer is
+ *      bounded by the (width + 1) / 2 runs a row can hold; a component
+ *      that spans many rows is linked from row to row by its fates.
  *
  * CRE
- *      CRE if indices are out of bounds (via Bit2_get/put)
+ *      CRE if width/height <= 0, reader errors, or the spill file
+ *      cannot be created, written or read back
  ************************/
-void enq_if_black(Bit2_T img, int col, int row, Queue_T bitQ, Bit2_T edges)
+static void stream_unblack(Pnmrdr_T file, FILE *out)
 {
-        /* If the pixel at index is black and has not been traversed yet */
-        if (Bit2_get(img, col, row) == 1 && Bit2_get(edges, col, row) == 0) {
-                Index i;
-                NEW(i);
-                i->col = col;
-                i->row = row;
+        Pnmrdr_mapdata data = Pnmrdr_data(file);
+        assert(data.width > 0 && data.height > 0);
+        int width = data.width;
+        int height = data.height;
+
+        /* A row of width pixels has at most (width + 1) / 2 runs */
+        long max_runs = (width + 1L) / 2;
+        Row rows[2];
+        for (int k = 0; k < 2; k++) {
+                rows[k].segs = ALLOC(max_runs * sizeof(Segment));
+                rows[k].border = ALLOC(max_runs);
+                rows[k].fate = ALLOC(max_runs * sizeof(int));
+                rows[k].nsegs = 0;
+                rows[k].ncomps = 0;
+        }
+        Labels labels;
+        labels.parent = ALLOC(2 * max_runs * sizeof(int));
+        labels.border = ALLOC(2 * max_runs);
+        labels.comp = ALLOC(2 * max_runs * sizeof(int));
+
+        FILE *spill = tmpfile();
+        assert(spill != NULL);
+
+        Row *above = &rows[0];
+        Row *row = &rows[1];
+        for (int r = 0; r < height; r++) {
+                row->nsegs = read_segments(file, width, row->segs);
+                label_row(&labels, above, row, r == 0 || r == height - 1,
+                          width);
+                if (r > 0) {
+                        spill_row(spill, above);
+                }
 
-                /* Enqueue the pixel to the queue and mark it in the bit array*/
-                Queue_enq(bitQ, i);
-                Bit2_put(edges, col, row, 1);
+                Row *swap = above;
+                above = row;
+                row = swap;
         }
+        /* Nothing continues below the last row */
+        for (int c = 0; c < above->ncomps; c++) {
+                above->fate[c] = above->border[c] ? FATE_BORDER
+                                                  : FATE_CLEAR;
+        }
+        spill_row(spill, above);
+
+        resolve_fates(spill, height, above, row);
+
+        rewind(spill);
+        int wpr = (width + BIT2_WORD_BITS - 1) / BIT2_WORD_BITS;
+        uint64_t *line = ALLOC(wpr * (long)sizeof(*line));
+        Pnmwrite_T writer = Pnmwrite_new(out, width, height, raw_output);
+
+        for (int r = 0; r < height; r++) {
+                long start;
+
+                spill_read(spill, &row->nsegs, sizeof(int), 1);
+                spill_read(spill, row->segs, sizeof(Segment), row->nsegs);
+                spill_read(spill, &row->ncomps, sizeof(int), 1);
+                spill_read(spill, row->fate, sizeof(int), row->ncomps);
+                spill_read(spill, &start, sizeof(start), 1);
+                print_segments(row, line, wpr);
+                Pnmwrite_row(writer, line);
+        }
+
+        Pnmwrite_free(&writer);
+        fclose(spill);
+        FREE(line);
+        for (int k = 0; k < 2; k++) {
+                FREE(rows[k].segs);
+                FREE(rows[k].border);
+                FREE(rows[k].fate);
+        }
+        FREE(labels.parent);
+        FREE(labels.border);
+        FREE(labels.comp);
 }
 
-/********** print_pbm ********
- *
- * Prints the pbm with the information in the given Bit2 array
- *
- * Parameters:
- *      Bit2_T img:   the bit2 array of the image to be printed
- *
- * Return:
- *      none
- *
- * Expects:
- *      a Bit2 array that stores PBM data
- *
+/********** read_segments ********
+ * Read one row of width pixels and store its black runs, left to
+ * right, in segs (labels unset). Returns the number of runs.
  ************************/
-static void print_pbm(Bit2_T img)
-/********** print_pbm / print_bit ********
- * Emit plain PBM (P1) for the current image.
+static int read_segments(Pnmrdr_T file, int width, Segment *segs)
+{
+        int nsegs = 0;
+        int start = -1;
+
+        for (int col = 0; col < width; col++) {
+                int bit = Pnmrdr_get(file);
+
+                if (bit == 1 && start < 0) {
+                        start = col;
+                }
+                else if (bit == 0 && start >= 0) {
+                        segs[nsegs].left = start;
+                        segs[nsegs].right = col - 1;
+                        nsegs++;
+                        start = -1;
+                }
+        }
+        if (start >= 0) {
+                segs[nsegs].left = start;
+                segs[nsegs].right = width - 1;
+                nsegs++;
+        }
+
+        return nsegs;
+}
+
+/********** label_row ********
+ * Group the runs of a row into components, and decide the fate of
+ * every component of the row above.
  *
  * Parameters:
- *      Bit2_T img
+ *      Labels *labels: scratch union-find of at least above->ncomps +
+ *                      row->nsegs labels
+ *      Row *above:     the row above, labelled (ncomps 0 for row 0);
+ *                      its fates are set
+ *      Row *row:       this row, with segs and nsegs read; its labels,
+ *                      ncomps and border flags are set
+ *      int edge_row:   nonzero for the first and last rows, whose every
+ *                      run touches the border
+ *      int width:      image width
  *
- * Returns:
- *      None
+ * Effects:
+ *      Label c < above->ncomps is component c of the row above, and
+ *      label above->ncomps + i is run i of this row. Every run is
+ *      united with each component above that it overlaps, so two runs
+ *      joined through earlier rows share a component here too. A
+ *      component above whose label ends up with no run of this row has
+ *      ended, and its fate is its border flag; otherwise its fate is
+ *      the component of this row it continues as.
  *
- * Output:
- *      Prints "P1\nW H\n" followed by W*H 0/1 values, newline at row end.
+ * Notes:
+ *      Both rows are sorted, so a single forward pointer into above
+ *      suffices; a run above that reaches past the current run may
+ *      overlap the next one too, so it is not skipped.
  ************************/
-void print_pbm(Bit2_T img)
+static void label_row(Labels *labels, Row *above, Row *row, int edge_row,
+                      int width)
 {
-        printf("P1\n%d %d\n", Bit2_width(img), Bit2_height(img));
-        Bit2_map_row_major(img, print_bit, NULL);
+        int base = above->ncomps;
+
+        for (int c = 0; c < base; c++) {
+                labels->parent[c] = c;
+                labels->border[c] = above->border[c];
+                labels->comp[c] = -1;
+        }
+        for (int i = 0; i < row->nsegs; i++) {
+                Segment *seg = &row->segs[i];
+
+                labels->parent[base + i] = base + i;
+                labels->border[base + i] = edge_row || seg->left == 0
+                                           || seg->right == width - 1;
+                labels->comp[base + i] = -1;
+        }
+
+        int a = 0;
+        for (int i = 0; i < row->nsegs; i++) {
+                const Segment *seg = &row->segs[i];
+
+                while (a < above->nsegs && above->segs[a].right < seg->left) {
+                        a++;
+                }
+                for (int k = a; k < above->nsegs
+                                && above->segs[k].left <= seg->right; k++) {
+                        union_labels(labels, above->segs[k].label, base + i);
+                }
+        }
+
+        row->ncomps = 0;
+        for (int i = 0; i < row->nsegs; i++) {
+                int root = find_label(labels, base + i);
+
+                if (labels->comp[root] < 0) {
+                        labels->comp[root] = row->ncomps;
+                        row->border[row->ncomps] = labels->border[root];
+                        row->ncomps++;
+                }
+                row->segs[i].label = labels->comp[root];
+        }
+
+        for (int c = 0; c < base; c++) {
+                int root = find_label(labels, c);
+
+                if (labels->comp[root] >= 0) {
+                        above->fate[c] = labels->comp[root];
+                }
+                else {
+                        above->fate[c] = labels->border[root] ? FATE_BORDER
+                                                              : FATE_CLEAR;
+                }
+        }
 }
 
-/********** print_bit ********
- *
- * the callback function to the map function in print_pbm. Prints the current 
- * bit
+/********** find_label ********
+ * Return the root label of label's component, halving the path to it.
+ ************************/
+static int find_label(Labels *labels, int label)
+{
+        int *parent = labels->parent;
+
+        while (parent[label] != label) {
+                parent[label] = parent[parent[label]];
+                label = parent[label];
+        }
+        return label;
+}
+
+/********** union_labels ********
+ * Merge the components of labels a and b. The merged root's border
+ * flag is set if either component's was.
+ ************************/
+static void union_labels(Labels *labels, int a, int b)
+{
+        a = find_label(labels, a);
+        b = find_label(labels, b);
+        if (a == b) {
+                return;
+        }
+        if (b < a) {
+                int swap = a;
+                a = b;
+                b = swap;
+        }
+
+        labels->parent[b] = a;
+        labels->border[a] |= labels->border[b];
+}
+
+/********** spill_row ********
+ * Append a row to the spill as "nsegs, segs, ncomps, fates, start",
+ * where start is the offset of the row's first byte, so resolve_fates
+ * can step from the end of one row back to the start of it.
+ ************************/
+static void spill_row(FILE *spill, const Row *row)
+{
+        long start = ftell(spill);
+        assert(start >= 0);
+
+        spill_write(spill, &row->nsegs, sizeof(int), 1);
+        spill_write(spill, row->segs, sizeof(Segment), row->nsegs);
+        spill_write(spill, &row->ncomps, sizeof(int), 1);
+        spill_write(spill, row->fate, sizeof(int), row->ncomps);
+        spill_write(spill, &start, sizeof(start), 1);
+}
+
+/********** resolve_fates ********
+ * Walk the spill from its last row to its first, rewriting every fate
+ * in place as FATE_CLEAR or FATE_BORDER: a component that continues
+ * takes the resolved fate of the component it continues as.
  *
  * Parameters:
- *      int col:      the column index of the pixel to be checked
- *      int row:      the row index of the pixel to be checked
- *      Bit2_T edges: the parallel bit2 array of img to mark traversed black 
- *                    edge pixels
- *      int bit:      the bit value of the current pixel
- *      void *cl:     a closure variable that is not used
- *
- * Notes:
- *      this function prints to standard output
- * 
+ *      FILE *spill:      the spill of all height rows
+ *      int height:       number of rows
+ *      Row *below, *row: scratch rows (fates and ncomps are used)
  ************************/
-static void print_bit(int col, int row, Bit2_T bit2, int bit, void *cl)
+static void resolve_fates(FILE *spill, int height, Row *below, Row *row)
 {
-        (void)row;
-        (void)cl;
-        printf("%d", bit);
-        if (col == Bit2_width(bit2) - 1) {
-                printf("\n");
+        long end = -(long)sizeof(long);
+        int rc = fseek(spill, end, SEEK_END);
+        assert(rc == 0);
+
+        for (int r = height - 1; r >= 0; r--) {
+                long start;
+
+                spill_read(spill, &start, sizeof(start), 1);
+                rc = fseek(spill, start, SEEK_SET);
+                assert(rc == 0);
+
+                spill_read(spill, &row->nsegs, sizeof(int), 1);
+                rc = fseek(spill, row->nsegs * (long)sizeof(Segment),
+                           SEEK_CUR);
+                assert(rc == 0);
+                spill_read(spill, &row->ncomps, sizeof(int), 1);
+                long fates = ftell(spill);
+                spill_read(spill, row->fate, sizeof(int), row->ncomps);
+
+                for (int c = 0; c < row->ncomps; c++) {
+                        if (row->fate[c] >= 0) {
+                                row->fate[c] = below->fate[row->fate[c]];
+                        }
+                }
+
+                /* A write after a read needs a seek in between */
+                rc = fseek(spill, fates, SEEK_SET);
+                assert(rc == 0);
+                spill_write(spill, row->fate, sizeof(int), row->ncomps);
+
+                if (r > 0) {
+                        rc = fseek(spill, start - (long)sizeof(long),
+                                   SEEK_SET);
+                        assert(rc == 0);
+                }
+
+                Row *swap = below;
+                below = row;
+                row = swap;
+        }
+        (void)rc;
+}
+
+/********** spill_write / spill_read ********
+ * Write or read n items of size bytes at the spill's position; CRE if
+ * fewer are transferred.
+ ************************/
+static void spill_write(FILE *spill, const void *p, size_t size, size_t n)
+{
+        size_t done = fwrite(p, size, n, spill);
+        assert(done == n);
+        (void)done;
+}
+
+static void spill_read(FILE *spill, void *p, size_t size, size_t n)
+{
+        size_t done = fread(p, size, n, spill);
+        assert(done == n);
+        (void)done;
+}
+
+/********** print_segments ********
+ * Build one output row as wpr packed words: 1 for pixels of runs whose
+ * component's resolved fate is FATE_CLEAR, 0 everywhere else.
+ ************************/
+static void print_segments(const Row *row, uint64_t *line, int wpr)
+{
+        memset(line, 0, wpr * sizeof(*line));
+
+        for (int i = 0; i < row->nsegs; i++) {
+                const Segment *seg = &row->segs[i];
+
+                if (row->fate[seg->label] == FATE_CLEAR) {
+                        Bit2_set_run_fast(line, seg->left, seg->right);
+                }
         }
-}
\ No newline at end of file
+}